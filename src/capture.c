@@ -0,0 +1,1017 @@
+//******************************************************************************
+//*                                  uBee512                                   *
+//*       An emulator for the Microbee Z80 ROM, FDD and HDD based models       *
+//*                                                                            *
+//*                               capture module                               *
+//*                                                                            *
+//*                       Copyright (C) 2007-2016 uBee                         *
+//******************************************************************************
+//
+// Screen hashing and image capture for automated testing.
+//
+// The visible CRTC area of the display surface is converted to 24 bit RGB,
+// one pixel per CRTC pixel regardless of the Y scale or the surface depth,
+// so the hash of a screen is the same for any video options.  The hash is
+// a 64 bit FNV-1a of the RGB data.
+//
+// The --screen-dump file holds the visible text screen decoded from video
+// memory, see crtc_screen_text(), for programs that poll the screen.
+//
+// Images are written as PNG or binary PPM files by a writer thread so the
+// emulation does not wait on file I/O.  The PNG files use uncompressed
+// deflate blocks so no compression library is needed.  When run without a
+// display (i.e. SDL_VIDEODRIVER=dummy) the display surface is still drawn
+// for each capture.
+//
+//==============================================================================
+/*
+ *  uBee512 - An emulator for the Microbee Z80 ROM, FDD and HDD based models.
+ *  Copyright (C) 2007-2016 uBee
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+//==============================================================================
+// ChangeLog (most recent entries are at top)
+//==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Video frames are recorded as black while the video is turned off
+//   instead of repeating the last image drawn.
+// - Added the --screen-dump text screen file, written every n frames when
+//   the text has changed and at exit.
+// - Created a new file to implement screen hashing and image capture.
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <SDL.h>
+#include <SDL_thread.h>
+
+#include "ubee512.h"
+#include "capture.h"
+#include "video.h"
+#include "crtc.h"
+#include "support.h"
+
+//==============================================================================
+// structures and variables
+//==============================================================================
+capture_t capture =
+{
+ .dump_every = CAPTURE_DUMP_EVERY
+};
+
+static capture_image_t capture_queue[CAPTURE_QUEUE_SIZE];
+static unsigned int capture_head;
+static unsigned int capture_tail;
+
+// The record head is only written by the emulation thread and the tail
+// only by the recording thread.
+static capture_frame_t capture_ring[CAPTURE_RECORD_FRAMES];
+static volatile unsigned int record_head;
+static volatile unsigned int record_tail;
+
+static uint32_t crc_table[256];
+
+// last text written by --screen-dump
+static char dump_text[CRTC_TEXT_SIZE];
+static char dump_last[CRTC_TEXT_SIZE];
+
+extern SDL_Surface *screen;
+extern emu_t emu;
+extern crtc_t crtc;
+extern video_t video;
+
+static void capture_queue_image (char *path, uint8_t *rgb, int w, int h);
+static void capture_screen_dump (int force);
+static void capture_record_close (void);
+static int capture_worker (void *data);
+static int capture_recorder (void *data);
+
+//==============================================================================
+// Capture initialise.
+//
+// The writer thread is only started if images are to be written and the
+// recording thread only if video is to be recorded.
+//
+//   pass: void
+// return: int                          0 if success, -1 if error
+//==============================================================================
+int capture_init (void)
+{
+ char *ext;
+ uint32_t c;
+ int i, j;
+
+ for (i = 0; i < 256; i++)
+    {
+     for (c = i, j = 0; j < 8; j++)
+        c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+     crc_table[i] = c;
+    }
+
+ capture.frame = 0;
+ capture.count = 0;
+ dump_last[0] = 0;
+ capture_head = 0;
+ capture_tail = 0;
+ record_head = 0;
+ record_tail = 0;
+
+ if ((! capture.file[0]) && (! capture.every) && (! capture.record[0]))
+    return 0;
+
+ capture.terminate = 0;
+ capture.mutex = SDL_CreateMutex();
+ capture.work = SDL_CreateCond();
+ capture.done = SDL_CreateCond();
+ capture.record_work = SDL_CreateCond();
+
+ if (capture.file[0] || capture.every)
+    {
+     capture.writerthread = SDL_CreateThread(capture_worker, NULL);
+     if (! capture.writerthread)
+        {
+         xprintf("capture_init: Unable to create the image writer thread\n");
+         return -1;
+        }
+    }
+
+ if (capture.record[0])
+    {
+     ext = strrchr(capture.record, '.');
+     capture.record_y4m = ext && (strcasecmp(ext, ".y4m") == 0);
+     capture.record_w = 0;
+     capture.record_h = 0;
+     capture.record_frames = 0;
+     capture.record_dropped = 0;
+     if (! (capture.record_fp = fopen(capture.record, "wb")))
+        {
+         xprintf("capture_init: Unable to create video file: %s\n",
+                 capture.record);
+         return -1;
+        }
+     capture.recordthread = SDL_CreateThread(capture_recorder, NULL);
+     if (! capture.recordthread)
+        {
+         xprintf("capture_init: Unable to create the video recording thread\n");
+         return -1;
+        }
+     capture.recording = 1;
+    }
+
+ return 0;
+}
+
+//==============================================================================
+// Capture de-initialise.
+//
+// Reports the final screen hash and writes the --screenshot image, then
+// waits for all queued images and video frames to be written.  Must be
+// called before the video module is de-initialised.
+//
+//   pass: void
+// return: int                          0
+//==============================================================================
+int capture_deinit (void)
+{
+ uint8_t *rgb;
+ int w, h;
+ int status;
+ int i;
+
+ if (capture.dump[0])
+    capture_screen_dump(1);
+
+ if (capture.hash_used || capture.file[0])
+    {
+     rgb = capture_rgb(&w, &h);
+     if (rgb && capture.hash_used)
+        xprintf("screen-hash: %d %016llx\n", capture.frame,
+                (unsigned long long)capture_hash(rgb, w * h * 3));
+     if (rgb && capture.file[0])
+        capture_queue_image(capture.file, rgb, w, h);
+     else
+        free(rgb);
+    }
+
+ capture.recording = 0;
+ if (capture.mutex)
+    {
+     SDL_LockMutex(capture.mutex);
+     capture.terminate = 1;
+     SDL_CondSignal(capture.work);
+     SDL_CondSignal(capture.record_work);
+     SDL_UnlockMutex(capture.mutex);
+    }
+ if (capture.writerthread)
+    {
+     SDL_WaitThread(capture.writerthread, &status);
+     capture.writerthread = NULL;
+    }
+ if (capture.recordthread)
+    {
+     SDL_WaitThread(capture.recordthread, &status);
+     capture.recordthread = NULL;
+    }
+ if (capture.record_fp)
+    {
+     capture_record_close();
+     capture.record_fp = NULL;
+    }
+ for (i = 0; i < CAPTURE_RECORD_FRAMES; i++)
+    {
+     free(capture_ring[i].pixels);
+     capture_ring[i].pixels = NULL;
+    }
+
+ if (capture.record_work)
+    SDL_DestroyCond(capture.record_work);
+ if (capture.work)
+    SDL_DestroyCond(capture.work);
+ if (capture.done)
+    SDL_DestroyCond(capture.done);
+ if (capture.mutex)
+    SDL_DestroyMutex(capture.mutex);
+ capture.record_work = NULL;
+ capture.work = NULL;
+ capture.done = NULL;
+ capture.mutex = NULL;
+
+ return 0;
+}
+
+//==============================================================================
+// Capture update.  Called once for each emulated frame.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void capture_update (void)
+{
+ char path[SSIZE1];
+ uint8_t *rgb;
+ int w, h;
+ int hash;
+ int image;
+
+ capture.frame++;
+
+ if (capture.dump[0] && ((capture.frame % capture.dump_every) == 0))
+    capture_screen_dump(0);
+
+ hash = capture.hash && ((capture.frame % capture.hash) == 0);
+ image = capture.every && ((capture.frame % capture.every) == 0);
+ if ((! hash) && (! image))
+    return;
+
+ if (! (rgb = capture_rgb(&w, &h)))
+    return;
+
+ if (hash)
+    xprintf("screen-hash: %d %016llx\n", capture.frame,
+            (unsigned long long)capture_hash(rgb, w * h * 3));
+
+ if (image)
+    {
+     snprintf(path, sizeof(path), "%s" SLASHCHAR_STR "ubee512-%08d.%s",
+              capture.dir, capture.count++,
+              (capture.format == CAPTURE_PPM) ? "ppm" : "png");
+     capture_queue_image(path, rgb, w, h);
+    }
+ else
+    free(rgb);
+}
+
+//==============================================================================
+// Write the visible text screen to the --screen-dump file.
+//
+// The file is only written if the text has changed since it was last
+// written.  It's written to a temporary file first and renamed so that a
+// program polling the file never sees it part written.
+//
+//   pass: int force                    1 to write even if not changed
+// return: void
+//==============================================================================
+static void capture_screen_dump (int force)
+{
+ char path[SSIZE1 + 4];
+ FILE *fp;
+ int n;
+
+ if ((n = crtc_screen_text(dump_text, sizeof(dump_text))) == -1)
+    return;
+ if ((! force) && (strcmp(dump_text, dump_last) == 0))
+    return;
+
+ snprintf(path, sizeof(path), "%s.tmp", capture.dump);
+ if (! (fp = fopen(path, "w")))
+    {
+     xprintf("capture_screen_dump: Unable to create file: %s\n", path);
+     capture.dump[0] = 0;
+     return;
+    }
+ fwrite(dump_text, 1, n, fp);
+ fclose(fp);
+
+#ifdef MINGW
+ remove(capture.dump);
+#endif
+ if (rename(path, capture.dump) != 0)
+    {
+     xprintf("capture_screen_dump: Unable to rename file: %s\n", path);
+     return;
+    }
+
+ strcpy(dump_last, dump_text);
+}
+
+//==============================================================================
+// Set the --screenshot-every values.
+//
+//   pass: char *p                      "n,dir" or "n,dir,format"
+// return: int                          0 if success, -1 if error
+//==============================================================================
+int capture_set_every (char *p)
+{
+ char *c;
+ char *f;
+
+ capture.every = atoi(p);
+ c = strchr(p, ',');
+ if ((capture.every < 1) || (! c) || (! c[1]))
+    return -1;
+
+ capture.format = CAPTURE_PNG;
+ f = strchr(c + 1, ',');
+ if (f)
+    {
+     if (strcmp(f + 1, "ppm") == 0)
+        capture.format = CAPTURE_PPM;
+     else if (strcmp(f + 1, "png") != 0)
+        return -1;
+     *f = 0;
+    }
+
+ strncpy(capture.dir, c + 1, sizeof(capture.dir));
+ capture.dir[sizeof(capture.dir) - 1] = 0;
+
+ return 0;
+}
+
+//==============================================================================
+// Get the visible CRTC area of the display as 24 bit RGB.
+//
+// Only the first scanline of each group of Y scaled lines is taken so the
+// image has the CRTC's own resolution.
+//
+//   pass: int *w                       width returned
+//         int *h                       height returned
+// return: uint8_t *                    RGB pixels (caller frees) or NULL
+//==============================================================================
+uint8_t *capture_rgb (int *w, int *h)
+{
+ crtc_frame_t f;
+ SDL_PixelFormat *fmt;
+ uint8_t *rgb;
+ uint8_t *dp;
+ uint8_t *sp;
+ uint32_t pixel;
+ int bpp;
+ int x, y;
+
+ if (! screen)
+    return NULL;
+
+ video_draw_surface();
+ crtc_get_frame(&f);
+
+ *w = f.hdisp * 8;
+ *h = f.vdisp * f.scans_per_row;
+ if (*w > screen->w)
+    *w = screen->w;
+ if (*h > screen->h / video.yscale)
+    *h = screen->h / video.yscale;
+ if ((*w <= 0) || (*h <= 0))
+    return NULL;
+
+ if (! (rgb = malloc(*w * *h * 3)))
+    {
+     xprintf("capture_rgb: Unable to allocate the image buffer\n");
+     return NULL;
+    }
+
+ if (SDL_MUSTLOCK(screen))
+    SDL_LockSurface(screen);
+
+ fmt = screen->format;
+ bpp = fmt->BytesPerPixel;
+ dp = rgb;
+ for (y = 0; y < *h; y++)
+    {
+     sp = (uint8_t *)screen->pixels + y * video.yscale * screen->pitch;
+     for (x = 0; x < *w; x++, sp += bpp, dp += 3)
+        {
+         switch (bpp)
+            {
+             case 1:
+                pixel = *sp;
+                break;
+             case 2:
+                pixel = *(uint16_t *)sp;
+                break;
+             case 3:
+                pixel = sp[0] | (sp[1] << 8) | (sp[2] << 16);
+                break;
+             default:
+                pixel = *(uint32_t *)sp;
+                break;
+            }
+         SDL_GetRGB(pixel, fmt, &dp[0], &dp[1], &dp[2]);
+        }
+    }
+
+ if (SDL_MUSTLOCK(screen))
+    SDL_UnlockSurface(screen);
+
+ return rgb;
+}
+
+//==============================================================================
+// Hash an image, 64 bit FNV-1a.
+//
+//   pass: uint8_t *rgb                 RGB pixels
+//         int size                     number of bytes
+// return: uint64_t                     hash value
+//==============================================================================
+uint64_t capture_hash (uint8_t *rgb, int size)
+{
+ uint64_t h = 0xcbf29ce484222325ULL;
+
+ while (size--)
+    {
+     h ^= *rgb++;
+     h *= 0x100000001b3ULL;
+    }
+
+ return h;
+}
+
+//==============================================================================
+// Queue an image to be written by the writer thread.  If the queue is full
+// this waits for the writer thread rather than dropping the image.
+//
+//   pass: char *path                   file to be written
+//         uint8_t *rgb                 RGB pixels, freed when written
+//         int w                        width
+//         int h                        height
+// return: void
+//==============================================================================
+static void capture_queue_image (char *path, uint8_t *rgb, int w, int h)
+{
+ capture_image_t *ip;
+ char *ext;
+
+ if (! capture.writerthread)
+    {
+     free(rgb);
+     return;
+    }
+
+ SDL_LockMutex(capture.mutex);
+ while ((capture_head - capture_tail) >= CAPTURE_QUEUE_SIZE)
+    SDL_CondWait(capture.done, capture.mutex);
+
+ ip = &capture_queue[capture_head % CAPTURE_QUEUE_SIZE];
+ strncpy(ip->path, path, sizeof(ip->path));
+ ip->path[sizeof(ip->path) - 1] = 0;
+ ip->rgb = rgb;
+ ip->w = w;
+ ip->h = h;
+ ext = strrchr(path, '.');
+ if (ext && (strcasecmp(ext, ".png") == 0))
+    ip->format = CAPTURE_PNG;
+ else
+    ip->format = CAPTURE_PPM;
+ capture_head++;
+
+ SDL_CondSignal(capture.work);
+ SDL_UnlockMutex(capture.mutex);
+}
+
+//==============================================================================
+// Update a CRC-32 value.
+//
+//   pass: uint32_t crc                 current CRC (complemented)
+//         uint8_t *p                   data
+//         int n                        number of bytes
+// return: uint32_t                     new CRC (complemented)
+//==============================================================================
+static uint32_t capture_crc (uint32_t crc, uint8_t *p, int n)
+{
+ while (n--)
+    crc = crc_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+ return crc;
+}
+
+//==============================================================================
+// Write a 32 bit big endian value.
+//
+//   pass: uint8_t *p                   destination
+//         uint32_t v                   value
+// return: void
+//==============================================================================
+static void capture_put32 (uint8_t *p, uint32_t v)
+{
+ p[0] = v >> 24;
+ p[1] = v >> 16;
+ p[2] = v >> 8;
+ p[3] = v;
+}
+
+//==============================================================================
+// Write a PNG chunk.
+//
+//   pass: FILE *fp                     file
+//         char *type                   4 character chunk type
+//         uint8_t *data                chunk data
+//         int n                        number of bytes
+// return: void
+//==============================================================================
+static void capture_png_chunk (FILE *fp, char *type, uint8_t *data, int n)
+{
+ uint8_t b[4];
+ uint32_t crc;
+
+ capture_put32(b, n);
+ fwrite(b, 1, 4, fp);
+ fwrite(type, 1, 4, fp);
+ fwrite(data, 1, n, fp);
+ crc = capture_crc(0xffffffff, (uint8_t *)type, 4);
+ crc = capture_crc(crc, data, n) ^ 0xffffffff;
+ capture_put32(b, crc);
+ fwrite(b, 1, 4, fp);
+}
+
+//==============================================================================
+// Write an image as a PNG file.
+//
+// The image data is a zlib stream of stored (uncompressed) deflate blocks,
+// each scanline is preceded by a filter type of 0.
+//
+//   pass: FILE *fp                     file
+//         capture_image_t *ip          image
+// return: int                          0 if success, -1 if error
+//==============================================================================
+static int capture_write_png (FILE *fp, capture_image_t *ip)
+{
+ static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a};
+ uint8_t ihdr[13];
+ uint8_t *raw;
+ uint8_t *z;
+ uint8_t *zp;
+ uint32_t a = 1;
+ uint32_t b = 0;
+ int rowbytes = ip->w * 3 + 1;
+ int size = rowbytes * ip->h;
+ int blocks = (size + 65534) / 65535;
+ int i, n;
+
+ raw = malloc(size);
+ z = malloc(2 + blocks * 5 + size + 4);
+ if ((! raw) || (! z))
+    {
+     free(raw);
+     free(z);
+     return -1;
+    }
+
+ for (i = 0; i < ip->h; i++)
+    {
+     raw[i * rowbytes] = 0;
+     memcpy(raw + i * rowbytes + 1, ip->rgb + i * ip->w * 3, ip->w * 3);
+    }
+
+ zp = z;
+ *zp++ = 0x78;
+ *zp++ = 0x01;
+ for (i = 0; i < size; i += n)
+    {
+     n = size - i;
+     if (n > 65535)
+        n = 65535;
+     *zp++ = (i + n == size);
+     *zp++ = n;
+     *zp++ = n >> 8;
+     *zp++ = ~n;
+     *zp++ = ~n >> 8;
+     memcpy(zp, raw + i, n);
+     zp += n;
+    }
+ for (i = 0; i < size; i++)
+    {
+     a = (a + raw[i]) % 65521;
+     b = (b + a) % 65521;
+    }
+ capture_put32(zp, (b << 16) | a);
+ zp += 4;
+
+ capture_put32(&ihdr[0], ip->w);
+ capture_put32(&ihdr[4], ip->h);
+ ihdr[8] = 8;                   /* bit depth */
+ ihdr[9] = 2;                   /* RGB colour */
+ ihdr[10] = 0;                  /* compression */
+ ihdr[11] = 0;                  /* filter */
+ ihdr[12] = 0;                  /* no interlace */
+
+ fwrite(signature, 1, sizeof(signature), fp);
+ capture_png_chunk(fp, "IHDR", ihdr, sizeof(ihdr));
+ capture_png_chunk(fp, "IDAT", z, zp - z);
+ capture_png_chunk(fp, "IEND", NULL, 0);
+
+ free(raw);
+ free(z);
+ return 0;
+}
+
+//==============================================================================
+// Write an image as a binary PPM file.
+//
+//   pass: FILE *fp                     file
+//         capture_image_t *ip          image
+// return: int                          0 if success, -1 if error
+//==============================================================================
+static int capture_write_ppm (FILE *fp, capture_image_t *ip)
+{
+ fprintf(fp, "P6\n%d %d\n255\n", ip->w, ip->h);
+ fwrite(ip->rgb, 1, ip->w * ip->h * 3, fp);
+ return 0;
+}
+
+//==============================================================================
+// Image writer thread.
+//
+// Writes queued images until told to terminate, any images still queued at
+// that time are written first.
+//
+//   pass: void *data
+// return: int                          0
+//==============================================================================
+static int capture_worker (void *data)
+{
+ capture_image_t image;
+ FILE *fp;
+ int res;
+
+ SDL_LockMutex(capture.mutex);
+ for (;;)
+    {
+     while ((capture_head == capture_tail) && (! capture.terminate))
+        SDL_CondWait(capture.work, capture.mutex);
+     if (capture_head == capture_tail)
+        break;
+     image = capture_queue[capture_tail % CAPTURE_QUEUE_SIZE];
+     SDL_UnlockMutex(capture.mutex);
+
+     res = -1;
+     if ((fp = fopen(image.path, "wb")) != NULL)
+        {
+         if (image.format == CAPTURE_PNG)
+            res = capture_write_png(fp, &image);
+         else
+            res = capture_write_ppm(fp, &image);
+         if (fclose(fp) != 0)
+            res = -1;
+        }
+     if (res != 0)
+        xprintf("capture: Unable to write image file: %s\n", image.path);
+     free(image.rgb);
+
+     SDL_LockMutex(capture.mutex);
+     capture_tail++;
+     SDL_CondSignal(capture.done);
+    }
+ SDL_UnlockMutex(capture.mutex);
+
+ return 0;
+}
+
+//==============================================================================
+// Video recording.
+//
+// Each frame the visible CRTC area of the display surface is copied as it
+// is, one line per CRTC scanline, into the next free buffer of a ring.  The
+// recording thread converts the frames to RGB or YUV and writes them.  If
+// the ring is full the frame is dropped so the emulation never waits on the
+// recording.
+//
+// The recording size is taken from the first frame with the CRTC set up,
+// later frames of a different size are clipped or padded with black.  A
+// YUV4MPEG2 (.y4m) file uses 4:4:4 BT.601 YUV, any other file name is
+// written as raw 24 bit RGB frames with a text file of the same name plus
+// '.txt' describing them.
+//==============================================================================
+
+//==============================================================================
+// Record a video frame.  Called once for each emulated frame when the
+// display surface is not being drawn on.
+//
+//   pass: int type                     CAPTURE_FRAME_NEW to copy the display
+//                                      surface, CAPTURE_FRAME_REPEAT if the
+//                                      display is unchanged since the last
+//                                      frame (i.e. the surface is still
+//                                      being drawn) or CAPTURE_FRAME_BLANK if
+//                                      the video is off
+// return: void
+//==============================================================================
+void capture_record_frame (int type)
+{
+ crtc_frame_t f;
+ capture_frame_t *fp;
+ SDL_PixelFormat *fmt;
+ unsigned int head;
+ uint8_t *dp;
+ int bpp;
+ int w, h, y;
+ int i;
+
+ if (! capture.recording)
+    return;
+
+ if (! capture.record_w)
+    {
+     crtc_get_frame(&f);
+     w = f.hdisp * 8;
+     h = f.vdisp * f.scans_per_row;
+     if (w > screen->w)
+        w = screen->w;
+     if (h > screen->h / video.yscale)
+        h = screen->h / video.yscale;
+     if ((w <= 0) || (h <= 0))
+        return;                 /* CRTC not set up yet */
+     for (i = 0; i < CAPTURE_RECORD_FRAMES; i++)
+        if (! (capture_ring[i].pixels = malloc(w * h * 4)))
+           {
+            xprintf("capture_record_frame: Unable to allocate frame buffers\n");
+            capture.recording = 0;
+            return;
+           }
+     capture.record_w = w;
+     capture.record_h = h;
+    }
+
+ head = record_head;
+ if ((head - record_tail) >= CAPTURE_RECORD_FRAMES)
+    {
+     capture.record_dropped++;
+     return;
+    }
+
+ fp = &capture_ring[head % CAPTURE_RECORD_FRAMES];
+ fp->type = type;
+ if (type == CAPTURE_FRAME_NEW)
+    {
+     crtc_get_frame(&f);
+     fmt = screen->format;
+     bpp = fmt->BytesPerPixel;
+     w = f.hdisp * 8;
+     h = f.vdisp * f.scans_per_row;
+     if (w > capture.record_w)
+        w = capture.record_w;
+     if (w > screen->w)
+        w = screen->w;
+     if (h > capture.record_h)
+        h = capture.record_h;
+     if (h > screen->h / video.yscale)
+        h = screen->h / video.yscale;
+     if (w < 0)
+        w = 0;
+     if (h < 0)
+        h = 0;
+
+     if (SDL_MUSTLOCK(screen))
+        SDL_LockSurface(screen);
+     dp = fp->pixels;
+     for (y = 0; y < h; y++, dp += capture.record_w * bpp)
+        {
+         memcpy(dp, (uint8_t *)screen->pixels + y * video.yscale * screen->pitch,
+                w * bpp);
+         if (w < capture.record_w)
+            memset(dp + w * bpp, 0, (capture.record_w - w) * bpp);
+        }
+     if (SDL_MUSTLOCK(screen))
+        SDL_UnlockSurface(screen);
+     if (h < capture.record_h)
+        memset(dp, 0, (capture.record_h - h) * capture.record_w * bpp);
+
+     fp->format = *fmt;
+     fp->format.palette = NULL;
+     if (fmt->palette)
+        {
+         fp->palette.ncolors = fmt->palette->ncolors;
+         fp->palette.colors = fp->colours;
+         memcpy(fp->colours, fmt->palette->colors,
+                fmt->palette->ncolors * sizeof(SDL_Color));
+         fp->format.palette = &fp->palette;
+        }
+    }
+
+ __sync_synchronize();          // frame must be visible before the head moves
+ record_head = head + 1;
+
+ SDL_LockMutex(capture.mutex);
+ SDL_CondSignal(capture.record_work);
+ SDL_UnlockMutex(capture.mutex);
+}
+
+//==============================================================================
+// Convert a recorded frame to the output format.
+//
+// The RGB to YUV conversion uses the BT.601 studio swing coefficients, the
+// Y, U and V planes follow each other.
+//
+//   pass: capture_frame_t *fp          frame
+//         uint8_t *out                 output frame
+// return: void
+//==============================================================================
+static void capture_record_convert (capture_frame_t *fp, uint8_t *out)
+{
+ SDL_PixelFormat *fmt = &fp->format;
+ uint8_t *sp = fp->pixels;
+ uint8_t *yp = out;
+ uint8_t *up = out + capture.record_w * capture.record_h;
+ uint8_t *vp = up + capture.record_w * capture.record_h;
+ uint8_t r, g, b;
+ uint32_t pixel;
+ int bpp = fmt->BytesPerPixel;
+ int i;
+
+ for (i = 0; i < capture.record_w * capture.record_h; i++, sp += bpp)
+    {
+     switch (bpp)
+        {
+         case 1:
+            pixel = *sp;
+            break;
+         case 2:
+            pixel = *(uint16_t *)sp;
+            break;
+         case 3:
+            pixel = sp[0] | (sp[1] << 8) | (sp[2] << 16);
+            break;
+         default:
+            pixel = *(uint32_t *)sp;
+            break;
+        }
+     SDL_GetRGB(pixel, fmt, &r, &g, &b);
+
+     if (capture.record_y4m)
+        {
+         *yp++ = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+         *up++ = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+         *vp++ = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+        }
+     else
+        {
+         *yp++ = r;
+         *yp++ = g;
+         *yp++ = b;
+        }
+    }
+}
+
+//==============================================================================
+// Fill an output frame with black.
+//
+//   pass: uint8_t *out                 output frame
+//         int size                     output frame size
+// return: void
+//==============================================================================
+static void capture_record_black (uint8_t *out, int size)
+{
+ if (capture.record_y4m)
+    {
+     memset(out, 16, size / 3);
+     memset(out + size / 3, 128, size * 2 / 3);
+    }
+ else
+    memset(out, 0, size);
+}
+
+//==============================================================================
+// Video recording thread.
+//
+// Writes queued frames until told to terminate, any frames still queued at
+// that time are written first.  A repeated frame writes the last frame
+// again, black if there is none, and a blank frame writes black.
+//
+//   pass: void *data
+// return: int                          0
+//==============================================================================
+static int capture_recorder (void *data)
+{
+ capture_frame_t *fp;
+ uint8_t *out = NULL;
+ unsigned int tail;
+ int size = 0;
+ int error = 0;
+
+ for (;;)
+    {
+     SDL_LockMutex(capture.mutex);
+     while ((record_tail == record_head) && (! capture.terminate))
+        SDL_CondWait(capture.record_work, capture.mutex);
+     SDL_UnlockMutex(capture.mutex);
+
+     tail = record_tail;
+     if (tail == record_head)
+        break;
+     __sync_synchronize();      // read the frame after seeing the head move
+
+     if (! out)
+        {
+         size = capture.record_w * capture.record_h * 3;
+         if (! (out = malloc(size)))
+            error = 1;
+         else
+            {
+             capture_record_black(out, size);
+             if (capture.record_y4m)
+                fprintf(capture.record_fp, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n",
+                        capture.record_w, capture.record_h, emu.framerate);
+            }
+        }
+
+     fp = &capture_ring[tail % CAPTURE_RECORD_FRAMES];
+     if (! error)
+        {
+         if (fp->type == CAPTURE_FRAME_NEW)
+            capture_record_convert(fp, out);
+         else if (fp->type == CAPTURE_FRAME_BLANK)
+            capture_record_black(out, size);
+        }
+     __sync_synchronize();      // frame must be read before it is released
+     record_tail = tail + 1;
+
+     if (! error)
+        {
+         if (capture.record_y4m)
+            fputs("FRAME\n", capture.record_fp);
+         if (fwrite(out, 1, size, capture.record_fp) != size)
+            {
+             xprintf("capture: Unable to write video file: %s\n",
+                     capture.record);
+             error = 1;
+            }
+         else
+            capture.record_frames++;
+        }
+    }
+
+ free(out);
+ return 0;
+}
+
+//==============================================================================
+// Close the video recording and write the description of a raw recording.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void capture_record_close (void)
+{
+ char path[SSIZE1 + 8];
+ FILE *fp;
+
+ fclose(capture.record_fp);
+
+ if (! capture.record_y4m)
+    {
+     snprintf(path, sizeof(path), "%s.txt", capture.record);
+     if ((fp = fopen(path, "w")) != NULL)
+        {
+         fprintf(fp, "format=rgb24\n");
+         fprintf(fp, "width=%d\n", capture.record_w);
+         fprintf(fp, "height=%d\n", capture.record_h);
+         fprintf(fp, "fps=%d\n", emu.framerate);
+         fprintf(fp, "frames=%d\n", capture.record_frames);
+         fclose(fp);
+        }
+    }
+
+ xprintf("record-video: %d frames written, %d dropped\n",
+         capture.record_frames, capture.record_dropped);
+}
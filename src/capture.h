@@ -0,0 +1,89 @@
+/* CAPTURE Header */
+
+#ifndef HEADER_CAPTURE_H
+#define HEADER_CAPTURE_H
+
+#include <stdint.h>
+#include <SDL.h>
+#include <SDL_thread.h>
+
+#include "ubee512.h"
+
+// number of images that may be waiting to be written
+#define CAPTURE_QUEUE_SIZE 4
+
+// number of recorded video frames that may be waiting to be written
+#define CAPTURE_RECORD_FRAMES 8
+
+// default frames between --screen-dump text screen checks
+#define CAPTURE_DUMP_EVERY 50
+
+// image file formats
+#define CAPTURE_PNG 0
+#define CAPTURE_PPM 1
+
+// recorded video frame types
+#define CAPTURE_FRAME_NEW    0  /* copied from the display surface */
+#define CAPTURE_FRAME_REPEAT 1  /* same image as the previous frame */
+#define CAPTURE_FRAME_BLANK  2  /* video is off, recorded as black */
+
+int capture_init (void);
+int capture_deinit (void);
+void capture_update (void);
+int capture_set_every (char *p);
+uint8_t *capture_rgb (int *w, int *h);
+uint64_t capture_hash (uint8_t *rgb, int size);
+void capture_record_frame (int type);
+
+typedef struct capture_image_t
+{
+ char path[SSIZE1];
+ uint8_t *rgb;                  /* 24 bit RGB pixels, top row first */
+ int w;
+ int h;
+ int format;
+}capture_image_t;
+
+typedef struct capture_frame_t
+{
+ uint8_t *pixels;               /* display surface pixels, one row per line */
+ int type;                      /* CAPTURE_FRAME_* frame type */
+ SDL_PixelFormat format;        /* display surface format when copied */
+ SDL_Palette palette;
+ SDL_Color colours[256];
+}capture_frame_t;
+
+typedef struct capture_t
+{
+ int hash;                      /* hash every n frames, 0 at exit only */
+ int hash_used;                 /* --screen-hash given */
+ char file[SSIZE1];             /* --screenshot file, written at exit */
+ int every;                     /* --screenshot-every frames */
+ char dir[SSIZE1];              /* --screenshot-every directory */
+ int format;                    /* --screenshot-every file format */
+
+ int frame;                     /* frames since start up */
+ int count;                     /* images written by --screenshot-every */
+
+ char dump[SSIZE1];             /* --screen-dump text file */
+ int dump_every;                /* --screen-dump-every frames */
+
+ char record[SSIZE1];           /* --record-video file */
+ int recording;                 /* video frames are being recorded */
+ int record_y4m;                /* YUV4MPEG2 file, else raw RGB */
+ int record_w;                  /* recording size, set by the first frame */
+ int record_h;
+ int record_frames;             /* frames written */
+ int record_dropped;            /* frames dropped with the ring full */
+ FILE *record_fp;
+
+ SDL_Thread *writerthread;
+ SDL_Thread *recordthread;
+ SDL_mutex *mutex;
+ SDL_cond *work;                /* signalled when an image is queued */
+ SDL_cond *done;                /* signalled when an image is written */
+ SDL_cond *record_work;         /* signalled when a frame is queued */
+ int terminate;
+}capture_t;
+
+#endif     /* HEADER_CAPTURE_H */
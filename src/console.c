@@ -32,6 +32,13 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Added console_raw_mode() and console_raw_read() for reading keys from
+//   stdin without waiting, used by the text terminal frontend.  Raw mode
+//   uses input_mode() and system_mode() and the tty settings are restored
+//   on exit or a fatal signal.
+// - input_mode() takes the minimum number of characters a read waits for.
+//
 // v5.5.0 - 21 June 2013, B.Robinson
 // - Added supporting functions console_exit_while_debugger_runs and
 //   console_resume_after_debugger_run to support new debugger
@@ -71,6 +78,7 @@
 #include <conio.h>
 #else
 #include <fcntl.h>      // setting keyboard flags
+#include <signal.h>
 #include <sys/ioctl.h>
 #include <termios.h>
 #include <X11/Xlib.h>
@@ -116,6 +124,16 @@ static int consoleoutput;
 // two global variables for tty and keyboard control
 static struct TERMIO_S term_orig;
 static int kbdflgs;
+
+// raw mode for the text terminal frontend, the tty settings are restored on
+// exit or a fatal signal
+static int raw_active;
+static int raw_restore_set;
+static const int raw_signals[] =
+{
+ SIGHUP, SIGINT, SIGQUIT, SIGTERM, SIGABRT, SIGSEGV, SIGBUS, SIGFPE
+};
+static void (*raw_handlers[sizeof(raw_signals) / sizeof(int)])(int);
 #endif
 
 extern char *c_argv[];
@@ -328,10 +346,11 @@ static void system_mode (void)
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // function : input_mode
 // purpose  : set the system into raw mode for keyboard i/o
+// pass     : vmin - minimum characters for a read to return, 0 to not wait
 // returns  : 0 - error
 //            1 - no error
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-static int input_mode (void)
+static int input_mode (int vmin)
 {
  struct TERMIO_S term;    // to avoid ^S ^Q processing
 
@@ -343,7 +362,7 @@ static int input_mode (void)
  term.c_iflag = 0;
  term.c_oflag = 0;
  term.c_lflag = 0;
- term.c_cc[VMIN] = 1;
+ term.c_cc[VMIN] = vmin;
  term.c_cc[VTIME] = 0;
  if (ioctl(0, TCSETA, &term) == -1)
     return (0);
@@ -364,17 +383,53 @@ static int input_mode (void)
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 int getch (void)
 {
- // no delays on reading stdin
- input_mode();
+ // no delays on reading stdin, already the case in terminal raw mode
+ if (! raw_active)
+    input_mode(1);
 
  // do a simple loop and get the response
  unsigned char ch;
  while (read(0, &ch, 1) != 1)
     ;
 
- system_mode();
+ if (! raw_active)
+    system_mode();
  return ch;
 }
+
+//==============================================================================
+// Restore the tty settings if in raw mode.  Registered with atexit() when
+// raw mode is first entered.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void console_raw_restore (void)
+{
+ if (! raw_active)
+    return;
+ raw_active = 0;
+ system_mode();
+}
+
+//==============================================================================
+// Fatal signal handler while raw mode may be in use.  The tty settings are
+// restored then the signal is raised again with the handler that was in
+// place before (i.e. the default or SDL's parachute).
+//
+//   pass: int sig_num
+// return: void
+//==============================================================================
+static void console_raw_signal (int sig_num)
+{
+ int i;
+
+ console_raw_restore();
+ for (i = 0; i < sizeof(raw_signals) / sizeof(int); i++)
+    if (raw_signals[i] == sig_num)
+       signal(sig_num, raw_handlers[i]);
+ raise(sig_num);
+}
 #endif
 
 #if 0
@@ -428,6 +483,75 @@ void console_set_keydevice (int d)
  console.key_device = d;
 }
 
+//==============================================================================
+// Set or restore the raw mode of stdin used by the text terminal frontend.
+// In raw mode there is no echo or line editing and reads return straight
+// away with whatever keys are available.
+//
+//   pass: int enable                   1 for raw mode, 0 to restore
+// return: int                          0 if success, -1 if error
+//==============================================================================
+int console_raw_mode (int enable)
+{
+#ifdef MINGW
+ return -1;
+#else
+ int i;
+
+ if (! enable)
+    {
+     console_raw_restore();
+     return 0;
+    }
+
+ if (raw_active)
+    return 0;
+ if (! input_mode(0))
+    return -1;
+ raw_active = 1;
+
+ if (! raw_restore_set)
+    {
+     atexit(console_raw_restore);
+     for (i = 0; i < sizeof(raw_signals) / sizeof(int); i++)
+        {
+         raw_handlers[i] = signal(raw_signals[i], console_raw_signal);
+         // leave ignored signals ignored
+         if (raw_handlers[i] == SIG_IGN)
+            signal(raw_signals[i], SIG_IGN);
+        }
+     raw_restore_set = 1;
+    }
+
+ return 0;
+#endif
+}
+
+//==============================================================================
+// Read the keys available from stdin while in raw mode.
+//
+//   pass: char *buf                    buffer for the keys
+//         int size                     size of the buffer
+// return: int                          number of keys read
+//==============================================================================
+int console_raw_read (char *buf, int size)
+{
+#ifdef MINGW
+ return 0;
+#else
+ int n;
+
+ if (! raw_active)
+    return 0;
+
+ n = read(0, buf, size);
+ if (n < 0)
+    return 0;
+
+ return n;
+#endif
+}
+
 //==============================================================================
 // Set console stream devices
 //
@@ -41,6 +41,8 @@ int getch (void);
 #endif
 int xgetch (void);
 void console_set_keydevice (int d);
+int console_raw_mode (int enable);
+int console_raw_read (char *buf, int size);
 void console_set_devices (int d);
 void console_add_device (int d);
 int console_get_devices (void);
@@ -32,6 +32,31 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Added crtc_screen_text() to get the visible text screen.
+// - Added a raster mode (--video-raster).  Display start address, scan
+//   lines per row and colour control writes are logged against the beam
+//   position with crtc_raster_write() and crtc_render() draws a frame with
+//   mid-frame writes in bands, other frames are drawn in a single pass.
+// - Added crtc_get_frame() to get the current display state for the OpenGL
+//   text renderer.
+// - vdu_propagate_pcg_updates() no longer takes the display range as the
+//   locations using a changed PCG glyph are found from an index.
+// - crtc_redraw() does nothing while the OpenGL text shader is in use.
+// - crtc_render() takes the redraw flags 64 locations at a time with
+//   vdu_redraw_take() and visits only the flagged cells, a frame with no
+//   flags set returns straight away.  Rows before the next flagged location
+//   found with vdu_redraw_next() are passed over and the frame ends once no
+//   flags are left.
+// - crtc_redraw() does nothing while the window is iconified.
+// - crtc_redraw() is now split into crtc_snapshot() which captures the
+//   CRTC and VDU state for a frame and crtc_render() which draws it.  This
+//   allows the drawing to be carried out by the video render thread.
+//   crtc_render() returns if anything was drawn instead of setting the
+//   crtc.update flag as it may be running on the render thread.
+// - crtc_update() no longer redraws the display when the render thread is
+//   running, the render thread is fed from video_update().
+//
 // v6.0.0 - 1 January 2017, K Duckmanton
 // - Refactored this module to only redraw those parts of the screen that
 //   have been changed.
@@ -213,6 +238,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdint.h>
 #include <SDL.h>
 
 #include "ubee512.h"
@@ -223,11 +249,13 @@
 #include "keystd.h"
 #include "vdu.h"
 #include "video.h"
+#include "gltext.h"
 
 //==============================================================================
 // structures and variables
 //==============================================================================
 static void crtc_calc_vsync_freq (void);
+static void crtc_raster_frame (void);
 int crtc_update_cursor (void);
 
 crtc_t crtc =
@@ -271,6 +299,19 @@ static int reg;
 static int mem_addr;
 static int redraw;
 
+static crtc_frame_t frame;
+
+// raster mode log of the last two emulated frames, indexed by frame & 1
+static struct
+{
+ uint64_t frame;
+ crtc_band_t base;
+ int bands;
+ crtc_band_t band[CRTC_BANDS];
+}raster[2] = {{.frame = UINT64_MAX}, {.frame = UINT64_MAX}};
+static crtc_band_t raster_cur;
+static int raster_last;
+
 #ifdef MINGW
 #else
 struct timeval tod_x;
@@ -320,6 +361,8 @@ static int crtc_videochange (void)
  int crt_w;
  int crt_h;
 
+ video_thread_sync();
+
  crt_w = crtc.hdisp * 8;
  crt_h = crtc.vdisp * crtc.scans_per_row;
 
@@ -375,6 +418,9 @@ int crtc_reset (void)
 {
  reg = 0;
 
+ raster[0].frame = raster[1].frame = UINT64_MAX;
+ raster_last = 0;
+
  return 0;
 }
 
@@ -597,6 +643,7 @@ void crtc_data_w (uint16_t port, uint8_t data, struct z80_port_write *port_s)
             crtc.resized = 1;
            }
         crtc_calc_vsync_freq();
+        crtc_raster_write();
         break;
 
      case CRTC_CUR_START:       // R10
@@ -614,11 +661,13 @@ void crtc_data_w (uint16_t port, uint8_t data, struct z80_port_write *port_s)
         crtc.disp_start &= 0xFF;
         crtc.disp_start |= (data & 0x3F) << 8;
         crtc_set_redraw();
+        crtc_raster_write();
         break;
      case CRTC_DISP_START_L:    // R13
         crtc.disp_start &= 0x3F00;
         crtc.disp_start |= data & 0xFF;
         crtc_set_redraw();
+        crtc_raster_write();
         break;
 
      case CRTC_CUR_POS_H:       // R14
@@ -654,6 +703,73 @@ void crtc_data_w (uint16_t port, uint8_t data, struct z80_port_write *port_s)
    }
 }
 
+//==============================================================================
+// Raster mode register write.
+//
+// Called after a write that changes the display start address, the scan
+// lines per row or the colour control port.  In raster mode the new values
+// are logged against the scan line the beam has reached, worked out from
+// the Z80 tstates the same way as crtc_vblank(), so a frame can later be
+// drawn in bands.  Writes made during the vertical blanking period apply
+// to the whole frame and those made after the last displayed scan line
+// apply from the next frame.  A write on the same scan line as the last
+// one, or one that would overflow the log, replaces the last band.
+//
+// The values in effect at the start of a frame are those after the last
+// write logged in any earlier frame.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void crtc_raster_write (void)
+{
+ uint64_t now;
+ uint64_t f;
+ int64_t phase;
+ int line;
+ int lines;
+ crtc_band_t *b;
+
+ if ((! crtc.raster) || (! vblank_divval))
+    return;
+
+ now = z80api_get_tstates();
+ f = now / vblank_divval;
+ phase = (int64_t)(now % vblank_divval) - vblank_cmpval;
+ lines = vtot * crtc.scans_per_row + vtot_adj;
+
+ if (raster[f & 1].frame != f)
+    {
+     raster[f & 1].frame = f;
+     raster[f & 1].base = raster_cur;
+     raster[f & 1].bands = 0;
+    }
+
+ raster_cur.disp_start = crtc.disp_start;
+ raster_cur.scans_per_row = crtc.scans_per_row;
+ raster_cur.colour_cont = vdu.colour_cont;
+
+ if (phase <= 0)
+    {
+     raster[f & 1].base = raster_cur;
+     return;
+    }
+
+ line = (int)((phase * lines) / vblank_divval);
+ if (line >= crtc.vdisp * crtc.scans_per_row)
+    return;
+
+ if (raster[f & 1].bands &&
+    ((raster[f & 1].band[raster[f & 1].bands - 1].line == line) ||
+    (raster[f & 1].bands == CRTC_BANDS)))
+    b = &raster[f & 1].band[raster[f & 1].bands - 1];
+ else
+    b = &raster[f & 1].band[raster[f & 1].bands++];
+
+ *b = raster_cur;
+ b->line = line;
+}
+
 //==============================================================================
 // redraw one screen address character position.
 //
@@ -684,40 +800,259 @@ void crtc_set_redraw (void)
 // Update the whole screen area if the global redraw flag is set, otherwise
 // only those character positions that have changed.
 //
+// If the render thread is running this waits for it to become idle and then
+// draws the current state on the calling thread.
+//
+// Nothing is drawn while the OpenGL text shader draws the display, the
+// redraw flags are left pending and gltext_active() requests a full redraw
+// when the shader stops being used.
+//
 //   pass: void
 // return: void
 //==============================================================================
 void crtc_redraw (void)
 {
- int i, j, x, y, l;
- int maddr;
-
- if (!crtc.video)
+ if (!crtc.video || video.hidden)
     return;                     /* redraws disabled */
+#ifdef USE_OPENGL
+ if (gltext_active())
+    return;                     /* drawn by the shader */
+#endif
 
- vdu_propagate_pcg_updates(crtc.disp_start, crtc.vdisp * crtc.hdisp);
+ video_thread_sync();
+ crtc_snapshot();
+ // signal to the video module that the screen needs to be redrawn
+ if (crtc_render())
+    crtc.update = 1;
+}
 
- maddr = crtc.disp_start;
- l = video.yscale * crtc.scans_per_row;
- for (y = 0, i = 0; i < crtc.vdisp; i++, y += l)
-    for (x = 0, j = 0; j < crtc.hdisp; j++, x += 8)
-       {
-        maddr &= 0x3fff;
-        if (redraw || vdu_char_is_redrawn(maddr))
-           {
-           vdu_draw_char(screen, 
-                         x, y,
-                         maddr,
-                         crtc.scans_per_row,
-                         crtc.flashvideo,
-                         (maddr == cur_pos) ? cur_blink : 0x00, cur_start, cur_end);
-           vdu_char_clear_redraw(maddr);
-           /* Signal to the video module that the screen needs to be redrawn */
-           crtc.update = 1;
-           }
-        maddr++;
-       }
+//==============================================================================
+// Take the raster mode bands for the frame being captured.
+//
+// The last complete emulated frame is drawn as the current one has not been
+// fully scanned yet.  If that frame had no mid-frame writes there are no
+// bands and the frame is drawn in a single pass from the current values.
+// Frames drawn in bands are redrawn in full, as is the first frame after
+// the bands stop.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void crtc_raster_frame (void)
+{
+ uint64_t f;
+
+ frame.colour_cont = vdu.colour_cont;
+ frame.bands = 0;
+
+ if (crtc.raster && vblank_divval)
+    {
+     f = z80api_get_tstates() / vblank_divval;
+
+     // keep the start of frame values in step with any unlogged changes
+     if (raster[f & 1].frame != f)
+        {
+         raster_cur.disp_start = crtc.disp_start;
+         raster_cur.scans_per_row = crtc.scans_per_row;
+         raster_cur.colour_cont = vdu.colour_cont;
+        }
+
+     if (f && (raster[(f - 1) & 1].frame == f - 1) &&
+        raster[(f - 1) & 1].bands)
+        {
+         frame.disp_start = raster[(f - 1) & 1].base.disp_start;
+         frame.scans_per_row = raster[(f - 1) & 1].base.scans_per_row;
+         frame.colour_cont = raster[(f - 1) & 1].base.colour_cont;
+         frame.bands = raster[(f - 1) & 1].bands;
+         memcpy(frame.band, raster[(f - 1) & 1].band,
+                frame.bands * sizeof(crtc_band_t));
+        }
+    }
+
+ if (frame.bands || raster_last)
+    frame.redraw = 1;
+ raster_last = frame.bands;
+}
+
+//==============================================================================
+// Capture the CRTC state needed to draw a frame.  The VDU state is also
+// captured if drawing is done from a snapshot.  The redraw flag is moved to
+// the frame so any full redraw not yet drawn is carried forward.
+//
+// Must not be called while the render thread is busy.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void crtc_snapshot (void)
+{
+ frame.disp_start = crtc.disp_start;
+ frame.hdisp = crtc.hdisp;
+ frame.vdisp = crtc.vdisp;
+ frame.scans_per_row = crtc.scans_per_row;
+ frame.flashvideo = crtc.flashvideo;
+ frame.cur_pos = cur_pos;
+ frame.cur_blink = cur_blink;
+ frame.cur_start = cur_start;
+ frame.cur_end = cur_end;
+ frame.redraw |= redraw;
  redraw = 0;
+
+ crtc_raster_frame();
+
+ vdu_frame_diff();
+ vdu_snapshot();
+}
+
+//==============================================================================
+// Get the current CRTC display state without taking a snapshot, the redraw
+// flag is left as it is.
+//
+//   pass: crtc_frame_t *f              display state returned
+// return: void
+//==============================================================================
+void crtc_get_frame (crtc_frame_t *f)
+{
+ f->disp_start = crtc.disp_start;
+ f->hdisp = crtc.hdisp;
+ f->vdisp = crtc.vdisp;
+ f->scans_per_row = crtc.scans_per_row;
+ f->flashvideo = crtc.flashvideo;
+ f->cur_pos = cur_pos;
+ f->cur_blink = cur_blink;
+ f->cur_start = cur_start;
+ f->cur_end = cur_end;
+ f->redraw = 0;
+ f->colour_cont = vdu.colour_cont;
+ f->bands = 0;
+}
+
+//==============================================================================
+// Draw the frame captured by crtc_snapshot().  This may be called from the
+// render thread so crtc.update is left to the caller to set.
+//
+// A frame with raster mode bands is drawn with each band's display start
+// address, scan lines per row and colour control value.  A band takes
+// effect from the first character row that starts on or after its scan
+// line, the row addresses carry on from the band's display start address.
+//
+//   pass: void
+// return: int                          1 if anything was drawn, else 0
+//==============================================================================
+int crtc_render (void)
+{
+ int drawn = 0;
+ int i, j, k, n, y, l;
+ int maddr, addr, d;
+ int scan, b;
+ int spr;
+ uint8_t colour_cont = 0;
+ uint64_t bits;
+
+ vdu_propagate_pcg_updates();
+
+ // nothing to do on a clean frame
+ if ((! frame.redraw) && (! vdu_redraw_pending()))
+    return 0;
+
+ if (frame.bands)
+    colour_cont = vdu_render_colour_cont(frame.colour_cont);
+
+ // each row is taken in runs of up to 64 locations and only the locations
+ // with a redraw flag set are visited.  Rows before the next flagged
+ // location are passed over.
+ maddr = frame.disp_start;
+ spr = frame.scans_per_row;
+ l = video.yscale * spr;
+ for (y = 0, scan = 0, b = 0, i = 0; i < frame.vdisp; i++, y += l, scan += spr)
+    {
+     if ((b < frame.bands) && (scan >= frame.band[b].line))
+        {
+         while ((b < frame.bands) && (scan >= frame.band[b].line))
+            b++;
+         maddr = frame.band[b - 1].disp_start;
+         spr = frame.band[b - 1].scans_per_row;
+         l = video.yscale * spr;
+         vdu_render_colour_cont(frame.band[b - 1].colour_cont);
+        }
+     if (frame.bands && (y + l > screen->h))
+        break;
+     if (! frame.redraw)
+        {
+         d = vdu_redraw_next(maddr & 0x3fff);
+         if (d < 0)
+            break;
+         if (d >= frame.hdisp)
+            {
+             maddr += frame.hdisp;
+             continue;
+            }
+        }
+     for (j = 0; j < frame.hdisp; j += n, maddr += n)
+        {
+         n = frame.hdisp - j;
+         if (n > 64)
+            n = 64;
+         maddr &= 0x3fff;
+         bits = vdu_redraw_take(maddr, n);
+         if (frame.redraw)
+            bits = ~(uint64_t)0 >> (64 - n);
+         while (bits)
+            {
+             k = __builtin_ctzll(bits);
+             addr = (maddr + k) & 0x3fff;
+             bits &= bits - 1;
+             vdu_draw_char(screen,
+                           (j + k) * 8, y,
+                           addr,
+                           spr,
+                           frame.flashvideo,
+                           (addr == frame.cur_pos) ? frame.cur_blink : 0x00,
+                           frame.cur_start, frame.cur_end);
+             drawn = 1;
+            }
+        }
+    }
+
+ if (frame.bands)
+    vdu_render_colour_cont(colour_cont);
+ frame.redraw = 0;
+
+ return drawn;
+}
+
+//==============================================================================
+// Get the visible text screen.
+//
+// The screen is decoded from the display start address for vdisp rows of
+// hdisp characters with the 14 bit CRTC address wrap, see vdu_text_char()
+// for how each location is decoded.  Each row ends with a new line.
+//
+//   pass: char *s                      buffer for the text
+//         int size                     size of the buffer (CRTC_TEXT_SIZE
+//                                      is always large enough)
+// return: int                          length of the text, -1 if the buffer
+//                                      is too small
+//==============================================================================
+int crtc_screen_text (char *s, int size)
+{
+ int row, col;
+ int addr;
+ int n = 0;
+
+ if ((crtc.hdisp + 1) * crtc.vdisp + 1 > size)
+    return -1;
+
+ addr = crtc.disp_start;
+ for (row = 0; row < crtc.vdisp; row++)
+    {
+     for (col = 0; col < crtc.hdisp; col++, addr++)
+        s[n++] = vdu_text_char(addr & 0x3fff);
+     s[n++] = '\n';
+    }
+ s[n] = 0;
+
+ return n;
 }
 
 //==============================================================================
@@ -809,7 +1144,10 @@ void crtc_update (void)
          vdu_propagate_flashing_attr(crtc.disp_start, crtc.vdisp * crtc.hdisp);
         }
     }
- crtc_redraw();
+
+ // the render thread is fed from video_update()
+ if (! video_thread_running())
+    crtc_redraw();
 }
 
 //==============================================================================
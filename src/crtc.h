@@ -28,6 +28,12 @@
 
 #define CRTC_DOSETADDR      31
 
+// buffer size needed by crtc_screen_text() for the largest screen
+#define CRTC_TEXT_SIZE ((256 + 1) * 128 + 1)
+
+// most display bands a frame may be drawn in, see crtc_raster_write()
+#define CRTC_BANDS          32
+
 extern int disp_start;
 
 int crtc_init (void);
@@ -35,6 +41,8 @@ int crtc_deinit (void);
 int crtc_reset (void);
 
 void crtc_redraw (void);
+void crtc_snapshot (void);
+int crtc_render (void);
 void crtc_set_redraw (void);
 void crtc_redraw_char (int addr, int dostdout);
 
@@ -50,6 +58,8 @@ void crtc_update (void);
 void crtc_regdump (void);
 int crtc_set_flash_rate (int n);
 void crtc_clock (int cpuclock);
+void crtc_raster_write (void);
+int crtc_screen_text (char *s, int size);
 
 typedef struct crtc_t
 {
@@ -70,6 +80,36 @@ typedef struct crtc_t
  int lpen_valid;
  int update_strobe;
  int update;
+ int raster;
 }crtc_t;
 
+// display state from a scan line on, logged by crtc_raster_write()
+typedef struct crtc_band_t
+{
+ int line;
+ int disp_start;
+ int scans_per_row;
+ int colour_cont;
+}crtc_band_t;
+
+// CRTC state the display is drawn from, see crtc_snapshot()
+typedef struct crtc_frame_t
+{
+ int disp_start;
+ int hdisp;
+ int vdisp;
+ int scans_per_row;
+ int flashvideo;
+ int cur_pos;
+ int cur_blink;
+ int cur_start;
+ int cur_end;
+ int redraw;
+ int colour_cont;
+ int bands;
+ crtc_band_t band[CRTC_BANDS];
+}crtc_frame_t;
+
+void crtc_get_frame (crtc_frame_t *f);
+
 #endif     /* HEADER_CRTC_H */
@@ -0,0 +1,383 @@
+//******************************************************************************
+//*                                  uBee512                                   *
+//*       An emulator for the Microbee Z80 ROM, FDD and HDD based models       *
+//*                                                                            *
+//*                               expand module                                *
+//*                                                                            *
+//*                       Copyright (C) 2007-2016 uBee                         *
+//******************************************************************************
+//
+// Expands 1 bit per pixel character rows into 8, 16 or 32 bit pixels.
+//
+// Each row of 8 pixels is expanded in one step and then written as many
+// times as the Y scale requires.  The 64 byte compare used by the VDU frame
+// difference mode is also here.  SSE2 and AVX2 versions are used when the
+// host CPU supports them, the choice is made at run time by expand_init()
+// so a single binary runs on any x86 CPU.  Other hosts use the portable
+// versions.
+//
+//==============================================================================
+/*
+ *  uBee512 - An emulator for the Microbee Z80 ROM, FDD and HDD based models.
+ *  Copyright (C) 2007-2016 uBee
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+//==============================================================================
+// ChangeLog (most recent entries are at top)
+//==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Created a new file to implement character row expansion.
+// - The frame difference compare versions are moved here from vdu.c so
+//   they are selected by expand_init() with the row expansion versions.
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "expand.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define EXPAND_X86
+#include <immintrin.h>
+#endif
+
+//==============================================================================
+// structures and variables
+//==============================================================================
+static void expand_rows_8bpp (uint8_t *dst, int pitch, const uint8_t *src,
+                              int lines, int yscale, uint32_t fg, uint32_t bg);
+static void expand_rows_16bpp (uint8_t *dst, int pitch, const uint8_t *src,
+                               int lines, int yscale, uint32_t fg, uint32_t bg);
+static void expand_rows_32bpp (uint8_t *dst, int pitch, const uint8_t *src,
+                               int lines, int yscale, uint32_t fg, uint32_t bg);
+static uint64_t expand_diff64 (uint8_t *shadow, const uint8_t *ram);
+
+expand_rows_fn expand_rows_p[5] =
+{
+ NULL,
+ expand_rows_8bpp,
+ expand_rows_16bpp,
+ NULL,
+ expand_rows_32bpp
+};
+
+expand_diff64_fn expand_diff64_p = expand_diff64;
+
+static const char *expand_kernel = "C";
+
+// a byte with each bit spread out to 8 bits, used by the 8 bpp version
+static uint64_t expand_mask8[256];
+
+//==============================================================================
+// Portable versions.
+//
+//   pass: see expand_rows_fn in expand.h
+// return: void
+//==============================================================================
+static void expand_rows_8bpp (uint8_t *dst, int pitch, const uint8_t *src,
+                              int lines, int yscale, uint32_t fg, uint32_t bg)
+{
+ uint64_t fg8 = (uint8_t)fg * 0x0101010101010101ULL;
+ uint64_t bg8 = (uint8_t)bg * 0x0101010101010101ULL;
+ uint64_t m;
+ uint64_t px;
+ int y1;
+
+ while (lines--)
+    {
+     m = expand_mask8[*src++];
+     px = (fg8 & m) | (bg8 & ~m);
+     for (y1 = 0; y1 < yscale; y1++, dst += pitch)
+        memcpy(dst, &px, 8);
+    }
+}
+
+static void expand_rows_16bpp (uint8_t *dst, int pitch, const uint8_t *src,
+                               int lines, int yscale, uint32_t fg, uint32_t bg)
+{
+ uint16_t px[8];
+ int y1;
+ int i;
+ uint8_t d;
+
+ while (lines--)
+    {
+     for (i = 0, d = *src++; i < 8; i++, d <<= 1)
+        px[i] = (d & 0x80) ? fg : bg;
+     for (y1 = 0; y1 < yscale; y1++, dst += pitch)
+        memcpy(dst, px, sizeof(px));
+    }
+}
+
+static void expand_rows_32bpp (uint8_t *dst, int pitch, const uint8_t *src,
+                               int lines, int yscale, uint32_t fg, uint32_t bg)
+{
+ uint32_t px[8];
+ int y1;
+ int i;
+ uint8_t d;
+
+ while (lines--)
+    {
+     for (i = 0, d = *src++; i < 8; i++, d <<= 1)
+        px[i] = (d & 0x80) ? fg : bg;
+     for (y1 = 0; y1 < yscale; y1++, dst += pitch)
+        memcpy(dst, px, sizeof(px));
+    }
+}
+
+//==============================================================================
+// Portable frame difference compare.
+//
+//   pass: see expand_diff64_fn in expand.h
+// return: uint64_t                     1 bit for each byte that differed
+//==============================================================================
+static uint64_t expand_diff64 (uint8_t *shadow, const uint8_t *ram)
+{
+ uint64_t a;
+ uint64_t b;
+ uint64_t bits = 0;
+ int i;
+ int j;
+
+ for (i = 0; i < 64; i += 8)
+    {
+     memcpy(&a, shadow + i, 8);
+     memcpy(&b, ram + i, 8);
+     if (a == b)
+        continue;
+     for (j = 0; j < 8; j++)
+        if (shadow[i + j] != ram[i + j])
+           bits |= (uint64_t)1 << (i + j);
+     memcpy(shadow + i, ram + i, 8);
+    }
+
+ return bits;
+}
+
+#ifdef EXPAND_X86
+//==============================================================================
+// SSE2 versions.
+//
+// The row byte is copied into every lane and each lane tested against its
+// own bit to give an all ones or all zeros select mask for the lane.
+//
+//   pass: see expand_rows_fn in expand.h
+// return: void
+//==============================================================================
+__attribute__((target("sse2")))
+static void expand_rows_8bpp_sse2 (uint8_t *dst, int pitch, const uint8_t *src,
+                                   int lines, int yscale, uint32_t fg, uint32_t bg)
+{
+ const __m128i bits = _mm_setr_epi8(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                    0, 0, 0, 0, 0, 0, 0, 0);
+ const __m128i vfg = _mm_set1_epi8(fg);
+ const __m128i vbg = _mm_set1_epi8(bg);
+ __m128i sel;
+ __m128i px;
+ int y1;
+
+ while (lines--)
+    {
+     sel = _mm_and_si128(_mm_set1_epi8(*src++), bits);
+     sel = _mm_cmpeq_epi8(sel, bits);
+     px = _mm_or_si128(_mm_and_si128(sel, vfg), _mm_andnot_si128(sel, vbg));
+     for (y1 = 0; y1 < yscale; y1++, dst += pitch)
+        _mm_storel_epi64((__m128i *)dst, px);
+    }
+}
+
+__attribute__((target("sse2")))
+static void expand_rows_16bpp_sse2 (uint8_t *dst, int pitch, const uint8_t *src,
+                                    int lines, int yscale, uint32_t fg, uint32_t bg)
+{
+ const __m128i bits = _mm_setr_epi16(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+ const __m128i vfg = _mm_set1_epi16(fg);
+ const __m128i vbg = _mm_set1_epi16(bg);
+ __m128i sel;
+ __m128i px;
+ int y1;
+
+ while (lines--)
+    {
+     sel = _mm_and_si128(_mm_set1_epi16(*src++), bits);
+     sel = _mm_cmpeq_epi16(sel, bits);
+     px = _mm_or_si128(_mm_and_si128(sel, vfg), _mm_andnot_si128(sel, vbg));
+     for (y1 = 0; y1 < yscale; y1++, dst += pitch)
+        _mm_storeu_si128((__m128i *)dst, px);
+    }
+}
+
+__attribute__((target("sse2")))
+static void expand_rows_32bpp_sse2 (uint8_t *dst, int pitch, const uint8_t *src,
+                                    int lines, int yscale, uint32_t fg, uint32_t bg)
+{
+ const __m128i bits_l = _mm_setr_epi32(0x80, 0x40, 0x20, 0x10);
+ const __m128i bits_r = _mm_setr_epi32(0x08, 0x04, 0x02, 0x01);
+ const __m128i vfg = _mm_set1_epi32(fg);
+ const __m128i vbg = _mm_set1_epi32(bg);
+ __m128i d;
+ __m128i sel;
+ __m128i px_l;
+ __m128i px_r;
+ int y1;
+
+ while (lines--)
+    {
+     d = _mm_set1_epi32(*src++);
+     sel = _mm_cmpeq_epi32(_mm_and_si128(d, bits_l), bits_l);
+     px_l = _mm_or_si128(_mm_and_si128(sel, vfg), _mm_andnot_si128(sel, vbg));
+     sel = _mm_cmpeq_epi32(_mm_and_si128(d, bits_r), bits_r);
+     px_r = _mm_or_si128(_mm_and_si128(sel, vfg), _mm_andnot_si128(sel, vbg));
+     for (y1 = 0; y1 < yscale; y1++, dst += pitch)
+        {
+         _mm_storeu_si128((__m128i *)dst, px_l);
+         _mm_storeu_si128((__m128i *)(dst + 16), px_r);
+        }
+    }
+}
+
+//==============================================================================
+// AVX2 version.
+//
+// Only the 32 bpp row fills a 256 bit register, the 8 and 16 bpp rows are
+// handled by the SSE2 versions.
+//
+//   pass: see expand_rows_fn in expand.h
+// return: void
+//==============================================================================
+__attribute__((target("avx2")))
+static void expand_rows_32bpp_avx2 (uint8_t *dst, int pitch, const uint8_t *src,
+                                    int lines, int yscale, uint32_t fg, uint32_t bg)
+{
+ const __m256i bits = _mm256_setr_epi32(0x80, 0x40, 0x20, 0x10,
+                                        0x08, 0x04, 0x02, 0x01);
+ const __m256i vfg = _mm256_set1_epi32(fg);
+ const __m256i vbg = _mm256_set1_epi32(bg);
+ __m256i sel;
+ __m256i px;
+ int y1;
+
+ while (lines--)
+    {
+     sel = _mm256_and_si256(_mm256_set1_epi32(*src++), bits);
+     sel = _mm256_cmpeq_epi32(sel, bits);
+     px = _mm256_blendv_epi8(vbg, vfg, sel);
+     for (y1 = 0; y1 < yscale; y1++, dst += pitch)
+        _mm256_storeu_si256((__m256i *)dst, px);
+    }
+}
+
+//==============================================================================
+// SSE2 and AVX2 frame difference compares.  The shadow is only written when
+// a byte differs.
+//
+//   pass: see expand_diff64_fn in expand.h
+// return: uint64_t                     1 bit for each byte that differed
+//==============================================================================
+__attribute__((target("sse2")))
+static uint64_t expand_diff64_sse2 (uint8_t *shadow, const uint8_t *ram)
+{
+ __m128i a;
+ __m128i b;
+ uint64_t eq = 0;
+ int i;
+
+ for (i = 0; i < 64; i += 16)
+    {
+     a = _mm_loadu_si128((const __m128i *)(shadow + i));
+     b = _mm_loadu_si128((const __m128i *)(ram + i));
+     eq |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) << i;
+    }
+ if (~eq)
+    memcpy(shadow, ram, 64);
+
+ return ~eq;
+}
+
+__attribute__((target("avx2")))
+static uint64_t expand_diff64_avx2 (uint8_t *shadow, const uint8_t *ram)
+{
+ __m256i a;
+ __m256i b;
+ uint64_t eq = 0;
+ int i;
+
+ for (i = 0; i < 64; i += 32)
+    {
+     a = _mm256_loadu_si256((const __m256i *)(shadow + i));
+     b = _mm256_loadu_si256((const __m256i *)(ram + i));
+     eq |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) << i;
+    }
+ if (~eq)
+    memcpy(shadow, ram, 64);
+
+ return ~eq;
+}
+#endif
+
+//==============================================================================
+// Expand initialise.
+//
+// Builds the 8 bpp mask table and selects the fastest versions the host
+// CPU supports.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void expand_init (void)
+{
+ uint8_t m[8];
+ int i, j;
+
+ for (i = 0; i < 256; i++)
+    {
+     for (j = 0; j < 8; j++)
+        m[j] = (i & (0x80 >> j)) ? 0xff : 0x00;
+     memcpy(&expand_mask8[i], m, sizeof(m));
+    }
+
+#ifdef EXPAND_X86
+ __builtin_cpu_init();
+ if (__builtin_cpu_supports("sse2"))
+    {
+     expand_rows_p[1] = expand_rows_8bpp_sse2;
+     expand_rows_p[2] = expand_rows_16bpp_sse2;
+     expand_rows_p[4] = expand_rows_32bpp_sse2;
+     expand_diff64_p = expand_diff64_sse2;
+     expand_kernel = "SSE2";
+    }
+ if (__builtin_cpu_supports("avx2"))
+    {
+     expand_rows_p[4] = expand_rows_32bpp_avx2;
+     expand_diff64_p = expand_diff64_avx2;
+     expand_kernel = "AVX2";
+    }
+#endif
+}
+
+//==============================================================================
+// Name of the instruction set used by the selected versions.
+//
+//   pass: void
+// return: const char *
+//==============================================================================
+const char *expand_name (void)
+{
+ return expand_kernel;
+}
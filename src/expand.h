@@ -0,0 +1,30 @@
+/* EXPAND Header */
+
+#ifndef HEADER_EXPAND_H
+#define HEADER_EXPAND_H
+
+#include <stdint.h>
+
+// Expand character rows into pixels.
+//
+//   dst                first pixel of the top row to be written
+//   pitch              bytes between destination rows
+//   src                character rows, bit 7 is the left most pixel
+//   lines              number of character rows
+//   yscale             number of times each row is written
+//   fg, bg             foreground and background pixel values
+typedef void (*expand_rows_fn)(uint8_t *dst, int pitch, const uint8_t *src,
+                               int lines, int yscale, uint32_t fg, uint32_t bg);
+
+// Compare 64 shadow bytes with the live RAM and bring the shadow up to date,
+// returns 1 bit for each byte that differed.
+typedef uint64_t (*expand_diff64_fn)(uint8_t *shadow, const uint8_t *ram);
+
+void expand_init (void);
+const char *expand_name (void);
+
+// indexed by the number of bytes per pixel, NULL if not supported
+extern expand_rows_fn expand_rows_p[5];
+extern expand_diff64_fn expand_diff64_p;
+
+#endif     /* HEADER_EXPAND_H */
@@ -31,6 +31,10 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Added diagnostics function 0x01 to copy the visible text screen into
+//   Z80 memory and 0x02 to show it on the console.
+//
 // v6.0.0 - 1 January 2017, K Duckmanton
 // - Microbee memory is now an array of uint8_t rather than char, all
 //   pointers to it must also be uint8_t*.
@@ -188,6 +192,7 @@
 #include "support.h"
 #include "z80debug.h"
 #include "crtc.h"
+#include "z80api.h"
 #include "joystick.h"
 #include "tapfile.h"
 
@@ -436,6 +441,38 @@ static void function_control (int addr)
     }
 }
 
+//==============================================================================
+// Copy the visible text screen into Z80 memory.
+//
+// The text is the same as returned by crtc_screen_text(), one line per row
+// ending with a new line (0x0A) and a 0 terminator.  The bytes are written
+// through the Z80 memory map so the buffer may cross a bank boundary.
+//
+//   pass: int addr             buffer address in Z80 map
+//         int size             size of the buffer
+// return: int                  length of the text, -1 if the buffer is too
+//                              small
+//==============================================================================
+static int function_screen_text (int addr, int size)
+{
+ char *s;
+ int n;
+ int i;
+
+ if (size > CRTC_TEXT_SIZE)
+    size = CRTC_TEXT_SIZE;
+
+ if (! (s = malloc(size)))
+    return -1;
+
+ n = crtc_screen_text(s, size);
+ for (i = 0; i <= n; i++)
+    z80api_write_mem((addr + i) & 0xffff, s[i]);
+
+ free(s);
+ return n;
+}
+
 //==============================================================================
 // Diagnostics functions
 //
@@ -461,6 +498,14 @@ static void function_diagnostics (int addr)
             flags = leu16_to_host(f->dump.htype);
             z80debug_dump_lines(NULL, addr1, lines, flags);
             break;
+         case 0x01 : // copy the visible text screen to Z80 memory
+            addr1 = leu16_to_host(f->screen.addr);
+            f->screen.res = host_to_le16(function_screen_text(addr1,
+                            leu16_to_host(f->screen.size)));
+            break;
+         case 0x02 : // show the visible text screen on the console
+            z80debug_dump_screen();
+            break;
          default :
             break;
         }
@@ -55,6 +55,16 @@ typedef struct ub_cmdres_t
     fp_t fp;
    }ub_cmdres_t;
 
+// screen text structure
+typedef struct ub_screen_t
+   {
+    uint16_t cmd;                       // sub command
+    uint16_t id;                        // 0xAA55 check ID
+    int16_t res;                        // result
+    uint16_t addr;                      // buffer address in Z80 map
+    uint16_t size;                      // size of the buffer
+   }ub_screen_t;
+
 // file structure
 typedef struct ub_file_t
    {
@@ -99,6 +109,7 @@ typedef union ub_func_u
    {
     ub_version_t version;
     ub_dump_t dump;
+    ub_screen_t screen;
     ub_stdio_input_t getchar;
     ub_stdio_char_t putchar;
     ub_stdio_str_t puts;
@@ -0,0 +1,610 @@
+//******************************************************************************
+//*                                  uBee512                                   *
+//*       An emulator for the Microbee Z80 ROM, FDD and HDD based models       *
+//*                                                                            *
+//*                           OpenGL text display module                       *
+//*                                                                            *
+//*                       Copyright (C) 2007-2016 uBee                         *
+//******************************************************************************
+//
+// Draws the text display on the GPU (--gl-text).
+//
+// Screen, attribute and colour RAM, the character ROM and PCG RAM are kept
+// in textures holding one byte per texel and a fragment shader works out
+// the colour of each display pixel from them using the CRTC geometry,
+// cursor and flashing state passed in as uniforms.  Each frame only the
+// rows of video memory that differ from what was last uploaded are sent to
+// the GPU, and nothing is drawn on the CPU.
+//
+// A table mapping each colour RAM value to its foreground and background
+// colour indexes, followed by the palette, is built on the CPU with
+// vdu_colour_pair() so the colour board models need no special handling in
+// the shader.
+//
+// The shader only uses OpenGL 2.0 and GLSL 1.10 so it also runs on Mesa's
+// software renderers.  The OSD is still drawn into the display surface, the
+// normal texture rendering is used while it's displayed or if the shader
+// can't be created.
+//
+//==============================================================================
+/*
+ *  uBee512 - An emulator for the Microbee Z80 ROM, FDD and HDD based models.
+ *  Copyright (C) 2007-2016 uBee
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+//==============================================================================
+// ChangeLog (most recent entries are at top)
+//==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - The shader is not used in raster mode (--video-raster).
+// - The shader is not used while video is being recorded.
+// - Created a new file to implement the OpenGL text display.
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <SDL.h>
+
+#include "ubee512.h"
+#include "gltext.h"
+#include "video.h"
+#include "crtc.h"
+#include "vdu.h"
+#include "support.h"
+#include "capture.h"
+
+#ifdef USE_OPENGL
+
+//==============================================================================
+// structures and variables
+//==============================================================================
+gltext_t gltext;
+
+// video RAM planes, in texture rows
+#define GLTEXT_PLANE_ROWS (SCR_RAM_SIZE / GLTEXT_VRAM_W)
+#define GLTEXT_ROM_SIZE 0x1000
+
+static uint8_t vram_shadow[3][SCR_RAM_SIZE];
+static uint8_t font_shadow[GLTEXT_ROM_SIZE + PCG_RAM_SIZE];
+static uint8_t colour_shadow[GLTEXT_COLOUR_H][GLTEXT_COLOUR_W][3];
+
+// uniform values for the current frame
+static GLfloat geom[4];
+static GLfloat cursor[4];
+static GLfloat mode[4];
+static GLfloat flash[2];
+
+// OpenGL 2.0 functions, obtained at run time
+static PFNGLCREATESHADERPROC p_glCreateShader;
+static PFNGLSHADERSOURCEPROC p_glShaderSource;
+static PFNGLCOMPILESHADERPROC p_glCompileShader;
+static PFNGLGETSHADERIVPROC p_glGetShaderiv;
+static PFNGLGETSHADERINFOLOGPROC p_glGetShaderInfoLog;
+static PFNGLDELETESHADERPROC p_glDeleteShader;
+static PFNGLCREATEPROGRAMPROC p_glCreateProgram;
+static PFNGLATTACHSHADERPROC p_glAttachShader;
+static PFNGLLINKPROGRAMPROC p_glLinkProgram;
+static PFNGLGETPROGRAMIVPROC p_glGetProgramiv;
+static PFNGLGETPROGRAMINFOLOGPROC p_glGetProgramInfoLog;
+static PFNGLDELETEPROGRAMPROC p_glDeleteProgram;
+static PFNGLUSEPROGRAMPROC p_glUseProgram;
+static PFNGLGETUNIFORMLOCATIONPROC p_glGetUniformLocation;
+static PFNGLUNIFORM1IPROC p_glUniform1i;
+static PFNGLUNIFORM2FVPROC p_glUniform2fv;
+static PFNGLUNIFORM4FVPROC p_glUniform4fv;
+static PFNGLACTIVETEXTUREPROC p_glActiveTexture;
+
+// Integer values are held in floats.  Every division is biased by half so
+// that floor() gives the right answer when the GPU divides by multiplying
+// with an inexact reciprocal.  The video RAM planes are GLTEXT_PLANE_ROWS
+// (64) texture rows apart.
+static const char *gltext_fragment_shader =
+"#version 110\n"
+"uniform sampler2D vram;\n"          // screen, attribute, colour RAM planes
+"uniform sampler2D font;\n"          // character ROM then PCG RAM
+"uniform sampler2D colour;\n"        // colour RAM lookup, palette
+"uniform vec2 texsize;\n"            // display texture size in pixels
+"uniform vec4 geom;\n"               // hdisp, scans per row, start, RAM size
+"uniform vec4 cursor;\n"             // address, start, end, shown
+"uniform vec4 mode;\n"               // extended RAM, PCG banks, ROM 1, inverse
+"uniform vec2 flash;\n"              // flashing blanks, flashing inverts
+"\n"
+"float idiv(float a, float b)\n"
+"{\n"
+" return floor((a + 0.5) / b);\n"
+"}\n"
+"\n"
+"float imod(float a, float b)\n"
+"{\n"
+" return a - b * idiv(a, b);\n"
+"}\n"
+"\n"
+"float ibit(float a, float n)\n"
+"{\n"
+" return imod(idiv(a, exp2(n)), 2.0);\n"
+"}\n"
+"\n"
+"float vbyte(float plane, float a)\n"
+"{\n"
+" vec2 t = vec2((imod(a, 128.0) + 0.5) / 128.0,\n"
+"               (plane * 64.0 + idiv(a, 128.0) + 0.5) / 256.0);\n"
+" return floor(texture2D(vram, t).r * 255.0 + 0.5);\n"
+"}\n"
+"\n"
+"void main()\n"
+"{\n"
+" vec2 p = floor(gl_TexCoord[0].xy * texsize);\n"
+" float col = idiv(p.x, 8.0);\n"
+" float row = idiv(p.y, geom.y);\n"
+" float line = p.y - row * geom.y;\n"
+" float maddr = imod(geom.z + row * geom.x + col, 16384.0);\n"
+" float a = imod(maddr, geom.w);\n"
+" float ch = vbyte(0.0, a);\n"
+" float attrib = mode.x * vbyte(1.0, a);\n"
+" float c = vbyte(2.0, a);\n"
+" float bank;\n"
+" float inverse = 0.0;\n"
+" float bits = 0.0;\n"
+" float b;\n"
+" float r0;\n"
+" float r1;\n"
+" vec2 fb;\n"
+"\n"
+" if (ch >= 128.0)\n"
+"    {\n"
+"     bank = imod(attrib, 16.0);\n"
+"     if (bank >= mode.y)\n"
+"        {\n"
+"         ch = 32.0;\n"
+"         bank = 0.0;\n"
+"        }\n"
+"     else\n"
+"        bank += 2.0;\n"
+"    }\n"
+" else\n"
+"    bank = mode.z * ibit(maddr, 13.0);\n"
+" ch = imod(ch, 128.0);\n"
+"\n"
+" if (attrib >= 128.0)\n"
+"    {\n"
+"     if (flash.x > 0.5)\n"
+"        ch = 32.0;\n"
+"     inverse = flash.y;\n"
+"    }\n"
+" if ((mode.w > 0.5) && (ibit(attrib, 6.0) > 0.5))\n"
+"    inverse = 1.0 - inverse;\n"
+"\n"
+" if ((cursor.w > 0.5) && (maddr == cursor.x))\n"
+"    {\n"
+"     if (cursor.y > cursor.z)\n"
+"        {\n"
+"         inverse = 1.0 - inverse;\n"
+"         r0 = cursor.z + 1.0;\n"
+"         r1 = cursor.y - cursor.z + 1.0;\n"
+"        }\n"
+"     else\n"
+"        {\n"
+"         r0 = cursor.y;\n"
+"         r1 = cursor.z - cursor.y + 1.0;\n"
+"        }\n"
+"     if ((line >= r0) && (line < r0 + r1))\n"
+"        inverse = 1.0 - inverse;\n"
+"    }\n"
+"\n"
+" if (line < 16.0)\n"
+"    {\n"
+"     b = (bank * 128.0 + ch) * 16.0 + line;\n"
+"     bits = floor(texture2D(font, vec2((imod(b, 256.0) + 0.5) / 256.0,\n"
+"                                       (idiv(b, 256.0) + 0.5) / 256.0)).r\n"
+"                  * 255.0 + 0.5);\n"
+"    }\n"
+"\n"
+" fb = floor(texture2D(colour, vec2((c + 0.5) / 256.0, 0.25)).rg * 255.0 + 0.5);\n"
+" if (inverse > 0.5)\n"
+"    fb = fb.yx;\n"
+" b = (ibit(bits, 7.0 - imod(p.x, 8.0)) > 0.5) ? fb.x : fb.y;\n"
+" gl_FragColor = texture2D(colour, vec2((b + 0.5) / 256.0, 0.75));\n"
+"}\n";
+
+extern emu_t emu;
+extern model_t modelx;
+extern crtc_t crtc;
+extern vdu_t vdu;
+extern video_t video;
+extern capture_t capture;
+extern SDL_Color col_table[64];
+
+//==============================================================================
+// Get the OpenGL 2.0 functions used.
+//
+//   pass: void
+// return: int                          0 if success, -1 if error
+//==============================================================================
+static int gltext_get_procs (void)
+{
+ int major = 0;
+ const char *version = (const char *)glGetString(GL_VERSION);
+
+ if ((! version) || (sscanf(version, "%d", &major) != 1) || (major < 2))
+    return -1;
+
+#define GLTEXT_PROC(type, name) \
+ if (! (p_##name = (type)SDL_GL_GetProcAddress(#name))) \
+    return -1;
+
+ GLTEXT_PROC(PFNGLCREATESHADERPROC, glCreateShader)
+ GLTEXT_PROC(PFNGLSHADERSOURCEPROC, glShaderSource)
+ GLTEXT_PROC(PFNGLCOMPILESHADERPROC, glCompileShader)
+ GLTEXT_PROC(PFNGLGETSHADERIVPROC, glGetShaderiv)
+ GLTEXT_PROC(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog)
+ GLTEXT_PROC(PFNGLDELETESHADERPROC, glDeleteShader)
+ GLTEXT_PROC(PFNGLCREATEPROGRAMPROC, glCreateProgram)
+ GLTEXT_PROC(PFNGLATTACHSHADERPROC, glAttachShader)
+ GLTEXT_PROC(PFNGLLINKPROGRAMPROC, glLinkProgram)
+ GLTEXT_PROC(PFNGLGETPROGRAMIVPROC, glGetProgramiv)
+ GLTEXT_PROC(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog)
+ GLTEXT_PROC(PFNGLDELETEPROGRAMPROC, glDeleteProgram)
+ GLTEXT_PROC(PFNGLUSEPROGRAMPROC, glUseProgram)
+ GLTEXT_PROC(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation)
+ GLTEXT_PROC(PFNGLUNIFORM1IPROC, glUniform1i)
+ GLTEXT_PROC(PFNGLUNIFORM2FVPROC, glUniform2fv)
+ GLTEXT_PROC(PFNGLUNIFORM4FVPROC, glUniform4fv)
+ GLTEXT_PROC(PFNGLACTIVETEXTUREPROC, glActiveTexture)
+
+#undef GLTEXT_PROC
+
+ return 0;
+}
+
+//==============================================================================
+// Compile and link the shader program.
+//
+//   pass: void
+// return: int                          0 if success, -1 if error
+//==============================================================================
+static int gltext_create_program (void)
+{
+ GLuint shader;
+ GLint status;
+ char log[1024];
+
+ shader = p_glCreateShader(GL_FRAGMENT_SHADER);
+ p_glShaderSource(shader, 1, &gltext_fragment_shader, NULL);
+ p_glCompileShader(shader);
+ p_glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+ if (! status)
+    {
+     p_glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+     xprintf("gltext_create: shader compile failed:\n%s\n", log);
+     p_glDeleteShader(shader);
+     return -1;
+    }
+
+ gltext.program = p_glCreateProgram();
+ p_glAttachShader(gltext.program, shader);
+ p_glLinkProgram(gltext.program);
+ p_glDeleteShader(shader);      // freed with the program
+ p_glGetProgramiv(gltext.program, GL_LINK_STATUS, &status);
+ if (! status)
+    {
+     p_glGetProgramInfoLog(gltext.program, sizeof(log), NULL, log);
+     xprintf("gltext_create: shader link failed:\n%s\n", log);
+     p_glDeleteProgram(gltext.program);
+     gltext.program = 0;
+     return -1;
+    }
+
+ gltext.u_vram = p_glGetUniformLocation(gltext.program, "vram");
+ gltext.u_font = p_glGetUniformLocation(gltext.program, "font");
+ gltext.u_colour = p_glGetUniformLocation(gltext.program, "colour");
+ gltext.u_texsize = p_glGetUniformLocation(gltext.program, "texsize");
+ gltext.u_geom = p_glGetUniformLocation(gltext.program, "geom");
+ gltext.u_cursor = p_glGetUniformLocation(gltext.program, "cursor");
+ gltext.u_mode = p_glGetUniformLocation(gltext.program, "mode");
+ gltext.u_flash = p_glGetUniformLocation(gltext.program, "flash");
+
+ return 0;
+}
+
+//==============================================================================
+// Create a texture with nearest filtering.
+//
+//   pass: int i                        texture number
+//         GLenum format                GL_LUMINANCE or GL_RGB
+//         int w                        width
+//         int h                        height
+// return: void
+//==============================================================================
+static void gltext_create_texture (int i, GLenum format, int w, int h)
+{
+ glBindTexture(GL_TEXTURE_2D, gltext.texture[i]);
+ glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+ glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+ glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+ glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+ glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE,
+              NULL);
+}
+
+//==============================================================================
+// Create the shader program and textures.  Called each time the OpenGL
+// display texture is created as the context may have been replaced.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void gltext_create (void)
+{
+ GLint units = 0;
+
+ gltext_destroy();
+
+ if (! video.gl_text)
+    return;
+
+ if (gltext_get_procs() == -1)
+    {
+     xprintf("gltext_create: OpenGL 2.0 is required for --gl-text\n");
+     return;
+    }
+
+ glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+ if (units < 3)
+    {
+     xprintf("gltext_create: not enough texture units for --gl-text\n");
+     return;
+    }
+
+ if (gltext_create_program() == -1)
+    return;
+
+ glGenTextures(3, gltext.texture);
+ gltext_create_texture(0, GL_LUMINANCE, GLTEXT_VRAM_W, GLTEXT_VRAM_H);
+ gltext_create_texture(1, GL_LUMINANCE, GLTEXT_FONT_W, GLTEXT_FONT_H);
+ gltext_create_texture(2, GL_RGB, GLTEXT_COLOUR_W, GLTEXT_COLOUR_H);
+
+ if (glGetError() != GL_NO_ERROR)
+    {
+     xprintf("gltext_create: unable to create the text textures\n");
+     gltext_destroy();
+     return;
+    }
+
+ gltext.ok = 1;
+ gltext.full = 1;
+
+ if (emu.verbose)
+    xprintf("gltext: text display drawn by the OpenGL shader\n");
+}
+
+//==============================================================================
+// Delete the shader program and textures.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void gltext_destroy (void)
+{
+ if (gltext.program)
+    p_glDeleteProgram(gltext.program);
+ if (gltext.texture[0])
+    glDeleteTextures(3, gltext.texture);
+ memset(gltext.texture, 0, sizeof(gltext.texture));
+ gltext.program = 0;
+ gltext.ok = 0;
+ gltext.full = 1;
+}
+
+//==============================================================================
+// Check if the display is to be drawn by the shader.  When the shader stops
+// being used (i.e. the OSD is shown, video is being recorded or raster mode
+// is enabled) the display surface is out of date so a full redraw is
+// requested.  The shader has no support for raster mode bands.
+//
+//   pass: void
+// return: int                          1 if the shader is used, else 0
+//==============================================================================
+int gltext_active (void)
+{
+ int active = gltext.ok && (video.type == VIDEO_GL) && crtc.video &&
+              (emu.display_context == EMU_EMU_CONTEXT) &&
+              (! capture.recording) && (! crtc.raster);
+
+ if (gltext.used && (! active))
+    {
+     gltext.used = 0;
+     crtc_set_redraw();
+    }
+
+ return active;
+}
+
+//==============================================================================
+// Upload the rows of a texture that differ from the shadow copy.  The
+// changed rows are sent as one band.
+//
+//   pass: uint8_t *shadow              copy of what the texture holds
+//         const uint8_t *src           current data
+//         int size                     bytes of data
+//         int w                        texture width
+//         int y                        first texture row of the data
+// return: int                          bytes uploaded
+//==============================================================================
+static int gltext_upload (uint8_t *shadow, const uint8_t *src, int size,
+                          int w, int y)
+{
+ int rows = size / w;
+ int first = -1;
+ int last = -1;
+ int i;
+
+ for (i = 0; i < rows; i++)
+    if (gltext.full || memcmp(shadow + i * w, src + i * w, w))
+       {
+        if (first == -1)
+           first = i;
+        last = i;
+       }
+
+ if (first == -1)
+    return 0;
+
+ rows = last - first + 1;
+ memcpy(shadow + first * w, src + first * w, rows * w);
+ glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y + first, w, rows,
+                 GL_LUMINANCE, GL_UNSIGNED_BYTE, shadow + first * w);
+
+ return rows * w;
+}
+
+//==============================================================================
+// Bring the textures and uniform values up to date for a new frame.
+//
+//   pass: void
+// return: int                          1 if the display has changed, else 0
+//==============================================================================
+int gltext_update (void)
+{
+ uint8_t table[GLTEXT_COLOUR_H][GLTEXT_COLOUR_W][3];
+ GLfloat last[14];
+ crtc_frame_t f;
+ int fgc, bgc;
+ int n = 0;
+ int i;
+
+ if (! gltext.ok)
+    return 0;
+
+ // video memory
+ glBindTexture(GL_TEXTURE_2D, gltext.texture[0]);
+ n += gltext_upload(vram_shadow[0], vdu.scr_ram, SCR_RAM_SIZE,
+                    GLTEXT_VRAM_W, 0);
+ n += gltext_upload(vram_shadow[1], vdu.att_ram, SCR_RAM_SIZE,
+                    GLTEXT_VRAM_W, GLTEXT_PLANE_ROWS);
+ n += gltext_upload(vram_shadow[2], vdu.col_ram, SCR_RAM_SIZE,
+                    GLTEXT_VRAM_W, GLTEXT_PLANE_ROWS * 2);
+
+ glBindTexture(GL_TEXTURE_2D, gltext.texture[1]);
+ n += gltext_upload(font_shadow, vdu.chr_rom, GLTEXT_ROM_SIZE,
+                    GLTEXT_FONT_W, 0);
+ n += gltext_upload(font_shadow + GLTEXT_ROM_SIZE, vdu.pcg_ram, PCG_RAM_SIZE,
+                    GLTEXT_FONT_W, GLTEXT_ROM_SIZE / GLTEXT_FONT_W);
+
+ // colour RAM lookup and palette
+ memset(table, 0, sizeof(table));
+ for (i = 0; i < 256; i++)
+    {
+     vdu_colour_pair(vdu.colour_cont, i, &fgc, &bgc);
+     table[0][i][0] = fgc;
+     table[0][i][1] = bgc;
+    }
+ for (i = 0; i < 64; i++)
+    {
+     table[1][i][0] = col_table[i].r;
+     table[1][i][1] = col_table[i].g;
+     table[1][i][2] = col_table[i].b;
+    }
+ if (gltext.full || memcmp(table, colour_shadow, sizeof(table)))
+    {
+     memcpy(colour_shadow, table, sizeof(table));
+     glBindTexture(GL_TEXTURE_2D, gltext.texture[2]);
+     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, GLTEXT_COLOUR_W, GLTEXT_COLOUR_H,
+                     GL_RGB, GL_UNSIGNED_BYTE, colour_shadow);
+     n += sizeof(table);
+    }
+
+ // uniform values
+ memcpy(last, geom, sizeof(geom));
+ memcpy(last + 4, cursor, sizeof(cursor));
+ memcpy(last + 8, mode, sizeof(mode));
+ memcpy(last + 12, flash, sizeof(flash));
+
+ crtc_get_frame(&f);
+ geom[0] = f.hdisp;
+ geom[1] = f.scans_per_row;
+ geom[2] = f.disp_start;
+ geom[3] = vdu.scr_mask + 1;
+ cursor[0] = f.cur_pos;
+ cursor[1] = f.cur_start;
+ cursor[2] = f.cur_end;
+ cursor[3] = (f.cur_blink != 0);
+ mode[0] = (vdu.extendram != 0);
+ mode[1] = modelx.pcg;
+ mode[2] = (emu.model != MOD_2MHZ);
+ mode[3] = (modelx.hwflash == HFV4);
+ flash[0] = (f.flashvideo == HFV4);
+ flash[1] = (f.flashvideo == HFV3);
+
+ gltext.uploads = n;
+ i = gltext.full;
+ gltext.full = 0;
+
+ return i || n || memcmp(last, geom, sizeof(geom)) ||
+        memcmp(last + 4, cursor, sizeof(cursor)) ||
+        memcmp(last + 8, mode, sizeof(mode)) ||
+        memcmp(last + 12, flash, sizeof(flash));
+}
+
+//==============================================================================
+// Select the shader program and textures for drawing the display quad.
+//
+//   pass: int texture_w                display texture width
+//         int texture_h                display texture height
+// return: void
+//==============================================================================
+void gltext_bind (int texture_w, int texture_h)
+{
+ GLfloat texsize[2];
+ int i;
+
+ if (gltext.full)
+    gltext_update();
+
+ p_glUseProgram(gltext.program);
+ for (i = 2; i >= 0; i--)
+    {
+     p_glActiveTexture(GL_TEXTURE0 + i);
+     glBindTexture(GL_TEXTURE_2D, gltext.texture[i]);
+    }
+ p_glUniform1i(gltext.u_vram, 0);
+ p_glUniform1i(gltext.u_font, 1);
+ p_glUniform1i(gltext.u_colour, 2);
+
+ texsize[0] = texture_w;
+ texsize[1] = texture_h;
+ p_glUniform2fv(gltext.u_texsize, 1, texsize);
+ p_glUniform4fv(gltext.u_geom, 1, geom);
+ p_glUniform4fv(gltext.u_cursor, 1, cursor);
+ p_glUniform4fv(gltext.u_mode, 1, mode);
+ p_glUniform2fv(gltext.u_flash, 1, flash);
+
+ gltext.used = 1;
+}
+
+//==============================================================================
+// Return to fixed function texturing after drawing the display quad.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void gltext_unbind (void)
+{
+ p_glUseProgram(0);
+ p_glActiveTexture(GL_TEXTURE0);
+}
+#endif
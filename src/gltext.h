@@ -0,0 +1,45 @@
+/* GLTEXT Header */
+
+#ifndef HEADER_GLTEXT_H
+#define HEADER_GLTEXT_H
+
+#ifdef USE_OPENGL
+#include <SDL/SDL_opengl.h>
+
+// texture sizes, each texel is one byte of video memory
+#define GLTEXT_VRAM_W 128       /* screen, attribute and colour RAM */
+#define GLTEXT_VRAM_H 256
+#define GLTEXT_FONT_W 256       /* character ROM then PCG RAM */
+#define GLTEXT_FONT_H 256
+#define GLTEXT_COLOUR_W 256     /* colour RAM lookup and palette */
+#define GLTEXT_COLOUR_H 2
+
+void gltext_create (void);
+void gltext_destroy (void);
+int gltext_active (void);
+int gltext_update (void);
+void gltext_bind (int texture_w, int texture_h);
+void gltext_unbind (void);
+
+typedef struct gltext_t
+{
+ int ok;                        /* shader program and textures created */
+ int used;                      /* last frame was drawn by the shader */
+ int full;                      /* all textures to be uploaded */
+
+ GLuint program;
+ GLuint texture[3];             /* video RAM, font, colour */
+ GLint u_vram;
+ GLint u_font;
+ GLint u_colour;
+ GLint u_texsize;
+ GLint u_geom;
+ GLint u_cursor;
+ GLint u_mode;
+ GLint u_flash;
+
+ int uploads;                   /* bytes uploaded by the last update */
+}gltext_t;
+#endif
+
+#endif     /* HEADER_GLTEXT_H */
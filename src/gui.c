@@ -31,6 +31,14 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - The status line is now made of fields that each cache their text.
+//   gui_status_update() and gui_status_set_persist() only mark fields as
+//   changed and gui_update() renders them no more often than the status
+//   time (--gui-status-time).  The title bar is only set if the line has
+//   changed.
+// - gui_update() returns without reading the time if nothing is pending.
+//
 // v5.5.0 - 21 June 2013, B.Robinson
 // - Updated title bar to show debug mode - running, tracing, stopped etc...
 //
@@ -186,7 +194,8 @@ gui_t gui =
 {
  .dclick_time=300,
  .mouse_wheel=GUI_MOUSE_WHEEL_VOL,
- .persist_time=GUI_PERSIST_TIME
+ .persist_time=GUI_PERSIST_TIME,
+ .status_time=GUI_STATUS_TIME
 };
 
 gui_status_t gui_status =
@@ -213,6 +222,34 @@ static int mouse_motion_ignore;
 
 static char padding[50];
 
+// status line fields in display order, see gui_status_format()
+enum
+{
+ GUI_FIELD_EMUVER,
+ GUI_FIELD_EMU,
+ GUI_FIELD_VER,
+ GUI_FIELD_TITLE,
+ GUI_FIELD_SYS,
+ GUI_FIELD_MODEL,
+ GUI_FIELD_STATE,
+ GUI_FIELD_RAM,
+ GUI_FIELD_SPEED,
+ GUI_FIELD_SERIAL,
+ GUI_FIELD_VSTATES,
+ GUI_FIELD_VOL,
+ GUI_FIELD_WIN,
+ GUI_FIELD_DRIVE,
+ GUI_FIELDS
+};
+
+#define GUI_FIELD_SIZE 80
+
+static char status_field[GUI_FIELDS][GUI_FIELD_SIZE];
+static char status_line[300];
+static int status_dirty;
+static int status_compose;
+static uint64_t status_next;
+
 static int drive;
 static int drive_spinner_pos;
 
@@ -358,240 +395,180 @@ int gui_status_padding (int n)
 
  memset(&padding, ' ', n);
  padding[n] = 0;
+ gui_status_update();
 
  return 0;
 }
 
 //==============================================================================
-// GUI emulator status line update
+// Format one status line field.  An empty string is returned if the field
+// is not displayed.
 //
-//   pass: void
+//   pass: int n                        field number (GUI_FIELD_*)
+//         char *s                      field text returned
 // return: void
 //==============================================================================
-void gui_status_update (void)
+static void gui_status_format (int n, char *s)
 {
  static char drive_spinner[5] = {"|/-\\"};
 
- int displayed = 0;
- int i;
-
- char status[300] = {""};
- char vstates[20] = {""};
  char convert[20];
 
- if (gui_status.emuver)
-    {
-     strcat(status, ICONSTRING"-"APPVER);
-     displayed++;
-    }
+ s[0] = 0;
 
- if (gui_status.emu)
-    {
-     if (displayed)
-        strcat(status, padding);
-     displayed++;
-     strcat(status, ICONSTRING);
-    }
+ // only the identification and paused fields are shown when paused
+ if (emu.paused && (n > GUI_FIELD_STATE))
+    return;
 
- if (gui_status.ver)
+ switch (n)
     {
-     if (displayed)
-        strcat(status, padding);
-     displayed++;
-     strcat(status, APPVER);
-    }
-
- if (gui_status.title)
-    {
-     if (displayed)
-        strcat(status, padding);
-     displayed++;
-     strcat(status, gui.title);
-    }
-
- if (gui_status.sys)
-    {
-     if (displayed)
-        strcat(status, padding);
-     displayed++;
-     strcat(status, modelc.systname);
-    }
-
- if (gui_status.model)
-    {
-     if (displayed)
-        strcat(status, padding);
-     displayed++;
-     toupper_string(convert, model_args[emu.model]);
-     strcat(status, convert);
-    }
-
- if (emu.paused)
-    {
-     if (displayed)
-        strcat(status, padding);
-     displayed++;
-     strcat(status, "[PAUSED]");
+     case GUI_FIELD_EMUVER :
+        if (gui_status.emuver)
+           strcpy(s, ICONSTRING"-"APPVER);
+        break;
+     case GUI_FIELD_EMU :
+        if (gui_status.emu)
+           strcpy(s, ICONSTRING);
+        break;
+     case GUI_FIELD_VER :
+        if (gui_status.ver)
+           strcpy(s, APPVER);
+        break;
+     case GUI_FIELD_TITLE :
+        if (gui_status.title)
+           snprintf(s, GUI_FIELD_SIZE, "%s", gui.title);
+        break;
+     case GUI_FIELD_SYS :
+        if (gui_status.sys)
+           snprintf(s, GUI_FIELD_SIZE, "%s", modelc.systname);
+        break;
+     case GUI_FIELD_MODEL :
+        if (gui_status.model)
+           {
+            toupper_string(convert, model_args[emu.model]);
+            strcpy(s, convert);
+           }
+        break;
+     case GUI_FIELD_STATE :
+        if (emu.paused)
+           strcpy(s, "[PAUSED]");
+        else
+           switch (debug.mode)
+              {
+               case Z80DEBUG_MODE_RUN :
+                  strcpy(s, "[RUNNING]");
+                  break;
+               case Z80DEBUG_MODE_TRACE :
+                  strcpy(s, "[TRACING]");
+                  break;
+               case Z80DEBUG_MODE_STOP :
+                  strcpy(s, "[STOPPED]");
+                  break;
+               case Z80DEBUG_MODE_STEP_QUIET:
+               case Z80DEBUG_MODE_STEP_VERBOSE :
+                  strcpy(s, "[STEP]");
+                  break;
+              }
+        break;
+     case GUI_FIELD_RAM :
+        if (gui_status.ram)
+           snprintf(s, GUI_FIELD_SIZE, "%dK", modelx.ram);
+        break;
+     case GUI_FIELD_SPEED :
+        if (gui_status.speed)
+           snprintf(s, GUI_FIELD_SIZE, "%.3fMHz", (float)emu.cpuclock / 1000000.0);
+        break;
+     case GUI_FIELD_SERIAL :
+        if ((gui_status.serial) && (coms1 != (deschand_t)-1))
+           snprintf(s, GUI_FIELD_SIZE, "%dN%d:%d", serial.databits, serial.stopbits, serial.tx_baud);
+        break;
+     case GUI_FIELD_VSTATES :
+        if (gui_status.mute && audio.mute)
+           strcat(s, ":M");
+        if (gui_status.mouse && mouse.active)
+           strcat(s, ":m");
+        if (gui_status.print && (printer.print_a_file || printer.print_b_file))
+           strcat(s, ":P");
+        if (gui_status.tape && (tape.in_status | tapfile.in_status))
+           strcat(s, ":Ti");
+        if (gui_status.tape && (tape.tape_o_file || tapfile.tape_o_file))
+           strcat(s, ":To");
+        if (gui_status.joy && joystick.joy)
+           {
+            if (joystick.mbee)
+               strcat(s, ":JS");
+            if (joystick.kbd)
+               {
+                snprintf(convert, sizeof(convert)-1, ":J%d", joystick.set);
+                strcat(s, convert);
+               }
+           }
+        if (s[0])
+           {
+            s[0] = '[';
+            strcat(s, "]");
+           }
+        break;
+     case GUI_FIELD_VOL :
+        if ((gui_status.vol) || (gui.persist_flags & GUI_PERSIST_VOL))
+           snprintf(s, GUI_FIELD_SIZE, "[vol %d%%]", audio.vol_percent);
+        break;
+     case GUI_FIELD_WIN :
+#ifdef USE_OPENGL
+        if (((gui_status.win) && (video.type == VIDEO_GL)) || (gui.persist_flags & GUI_PERSIST_WIN))
+           snprintf(s, GUI_FIELD_SIZE, "[win %d%%]", video.percent_size);
+#endif
+        break;
+     case GUI_FIELD_DRIVE :
+        if ((gui_status.shortdrive || gui_status.longdrive) && (gui.persist_flags & GUI_PERSIST_DRIVE))
+           {
+            if (gui_status.shortdrive)
+               snprintf(s, GUI_FIELD_SIZE, "%c: %c", drive, drive_spinner[drive_spinner_pos]);
+            else
+               snprintf(s, GUI_FIELD_SIZE, "Drive %c: %c", drive, drive_spinner[drive_spinner_pos]);
+           }
+        break;
     }
- else
-    {
-     if (debug.mode != Z80DEBUG_MODE_OFF)
-        {
-         if (displayed)
-            strcat(status, padding);
-         displayed++;
-
-         switch (debug.mode)
-            {
-             case Z80DEBUG_MODE_RUN :
-                strcat(status, "[RUNNING]");
-                break;
-
-             case Z80DEBUG_MODE_TRACE :
-                strcat(status, "[TRACING]");
-                break;
-
-             case Z80DEBUG_MODE_STOP :
-                strcat(status, "[STOPPED]");
-                break;
-
-             case Z80DEBUG_MODE_STEP_QUIET:
-             case Z80DEBUG_MODE_STEP_VERBOSE :
-                strcat(status, "[STEP]");
-                break;
-            }
-        }
-
-     if (gui_status.ram)
-        {
-         if (displayed)
-            strcat(status, padding);
-         displayed++;
-         snprintf(convert, sizeof(convert)-1, "%dK", modelx.ram);
-         strcat(status, convert);
-        }
-
-     if (gui_status.speed)
-        {
-         if (displayed)
-            strcat(status, padding);
-         displayed++;
-         snprintf(convert, sizeof(convert)-1, "%.3fMHz", (float)emu.cpuclock / 1000000.0);
-         strcat(status, convert);
-        }
-
-     if ((gui_status.serial) && (coms1 != (deschand_t)-1))
-        {
-         if (displayed)
-            strcat(status, padding);
-         displayed++;
-         snprintf(convert, sizeof(convert)-1, "%dN%d:%d", serial.databits, serial.stopbits, serial.tx_baud);
-         strcat(status, convert);
-        }
-
-     if (gui_status.mute && audio.mute)
-        {
-         strcat(vstates, "[M");
-         displayed++;
-        }
-
-     if (gui_status.mouse && mouse.active)
-        {
-         if (vstates[0])
-            strcat(vstates, ":m");
-         else
-            strcat(vstates, "[m");
-         displayed++;
-        }
-
-     if (gui_status.print && (printer.print_a_file || printer.print_b_file))
-        {
-         if (vstates[0])
-            strcat(vstates, ":P");
-         else
-            strcat(vstates, "[P");
-         displayed++;
-        }
-
-     if (gui_status.tape && (tape.in_status | tapfile.in_status))
-        {
-         if (vstates[0])
-            strcat(vstates, ":Ti");
-         else
-            strcat(vstates, "[Ti");
-         displayed++;
-        }
-
-     if (gui_status.tape && (tape.tape_o_file || tapfile.tape_o_file))
-        {
-         if (vstates[0])
-            strcat(vstates, ":To");
-         else
-            strcat(vstates, "[To");
-         displayed++;
-        }
-
-     if (gui_status.joy && joystick.joy)
-        {
-         if (joystick.mbee)
-            {
-             if (vstates[0])
-                strcat(vstates, ":JS");
-             else
-                strcat(vstates, "[JS");
-            }
-         if (joystick.kbd)
-            {
-             if (vstates[0])
-                strcat(vstates, ":J");
-             else
-                strcat(vstates, "[J");
-             snprintf(convert, sizeof(convert)-1, "%d", joystick.set);
-             strcat(vstates, convert);
-            }
-         displayed++;
-        }
-
-     if (vstates[0])
-        {
-         strcat(vstates, "]");
-         if (displayed)
-            strcat(status, padding);
-         strcat(status, vstates);
-        }
+}
 
-     if ((gui_status.vol) || (gui.persist_flags & GUI_PERSIST_VOL))
-        {
-         if (displayed)
-            strcat(status, padding);
-         displayed++;
-         snprintf(convert, sizeof(convert)-1, "[vol %d%%]", audio.vol_percent);
-         strcat(status, convert);
-        }
+//==============================================================================
+// GUI emulator status line render.
+//
+// Only the fields marked as changed are formatted again, the line is then
+// joined from the cached field text and the title bar is only set if the
+// line is different to what is already shown.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void gui_status_render (void)
+{
+ char s[GUI_FIELD_SIZE];
+ char status[300];
+ int changed = status_compose;
+ int i, n;
+
+ for (i = 0; i < GUI_FIELDS; i++)
+    if (status_dirty & (1 << i))
+       {
+        gui_status_format(i, s);
+        if (strcmp(s, status_field[i]) != 0)
+           {
+            strcpy(status_field[i], s);
+            changed = 1;
+           }
+       }
+ status_dirty = 0;
+ status_compose = 0;
 
-#ifdef USE_OPENGL
-     if (((gui_status.win) && (video.type == VIDEO_GL)) || (gui.persist_flags & GUI_PERSIST_WIN))
-        {
-         if (displayed)
-            strcat(status, padding);
-         displayed++;
-         snprintf(convert, sizeof(convert)-1, "[win %d%%]", video.percent_size);
-         strcat(status, convert);
-        }
-#endif
+ if (! changed)
+    return;
 
-     if ((gui_status.shortdrive || gui_status.longdrive) && (gui.persist_flags & GUI_PERSIST_DRIVE))
-        {
-         if (displayed)
-            strcat(status, padding);
-         displayed++;
-         if (gui_status.shortdrive)
-            snprintf(convert, sizeof(convert)-1, "%c: %c", drive, drive_spinner[drive_spinner_pos]);
-         else
-            snprintf(convert, sizeof(convert)-1, "Drive %c: %c", drive, drive_spinner[drive_spinner_pos]);
-         strcat(status, convert);
-        }
-    }
+ for (n = 0, i = 0; (i < GUI_FIELDS) && (n < sizeof(status)); i++)
+    if (status_field[i][0])
+       n += snprintf(status + n, sizeof(status) - n, "%s%s",
+                     n ? padding : "", status_field[i]);
+ status[sizeof(status)-1] = 0;
 
  if (gui_status.left)
     {
@@ -600,12 +577,31 @@ void gui_status_update (void)
      status[sizeof(status)-1] = 0;
     }
 
- SDL_WM_SetCaption(status, ICONSTRING);
+ if (strcmp(status, status_line) != 0)
+    {
+     strcpy(status_line, status);
+     SDL_WM_SetCaption(status, ICONSTRING);
+    }
+}
+
+//==============================================================================
+// GUI emulator status line update
+//
+// All fields are marked as changed, the line is rendered by gui_update() no
+// more often than the status time.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void gui_status_update (void)
+{
+ status_dirty = (1 << GUI_FIELDS) - 1;
+ status_compose = 1;
 }
 
 //==============================================================================
 // GUI emulator status line persist value set.  Only one persist value per
-// call is allowed.  The GUI status line is also updated.
+// call is allowed.  The status line field is marked as changed.
 //
 //   pass: int n                        flag value of the persist value to set
 //         int p                        parameter associated with persist value
@@ -624,16 +620,17 @@ void gui_status_set_persist (int f, int p)
         drive = p;
         drive_spinner_pos = (drive_spinner_pos + 1) & 0x03;
         gui.drive_persist_timer = ticks + gui.persist_time;
+        status_dirty |= 1 << GUI_FIELD_DRIVE;
         break;
      case GUI_PERSIST_VOL :
         gui.volume_persist_timer = ticks + gui.persist_time;
+        status_dirty |= 1 << GUI_FIELD_VOL;
         break;
      case GUI_PERSIST_WIN :
         gui.window_persist_timer = ticks + gui.persist_time;
+        status_dirty |= 1 << GUI_FIELD_WIN;
         break;
     }
-
- gui_status_update();
 }
 
 //==============================================================================
@@ -819,7 +816,15 @@ void gui_mousemotion_event (void)
 //==============================================================================
 void gui_update (void)
 {
- uint64_t ticks = time_get_ms();
+ uint64_t ticks;
+
+ // nothing is timed unless the status line has changed, a persist value
+ // is showing or the mouse cursor may need hiding
+ if ((! status_dirty) && (! gui.persist_flags) &&
+    (! (video.flags & SDL_FULLSCREEN)))
+    return;
+
+ ticks = time_get_ms();
 
  if ((! mouse.host_in_use) && (video.flags & SDL_FULLSCREEN) &&
  (emu.display_context != EMU_OSD_CONTEXT) && (ticks > mouse_cursor_time))
@@ -833,19 +838,25 @@ void gui_update (void)
      if ((gui.persist_flags & GUI_PERSIST_DRIVE) && (ticks >= gui.drive_persist_timer))
         {
          gui.persist_flags ^= GUI_PERSIST_DRIVE;
-         gui_status_update();
+         status_dirty |= 1 << GUI_FIELD_DRIVE;
         }
      if ((gui.persist_flags & GUI_PERSIST_VOL) && (ticks >= gui.volume_persist_timer))
         {
          gui.persist_flags ^= GUI_PERSIST_VOL;
-         gui_status_update();
+         status_dirty |= 1 << GUI_FIELD_VOL;
         }
      if ((gui.persist_flags & GUI_PERSIST_WIN) && (ticks >= gui.window_persist_timer))
         {
          gui.persist_flags ^= GUI_PERSIST_WIN;
-         gui_status_update();
+         status_dirty |= 1 << GUI_FIELD_WIN;
         }
     }
+
+ if (status_dirty && (ticks >= status_next))
+    {
+     gui_status_render();
+     status_next = ticks + gui.status_time;
+    }
 }
 
 //==============================================================================
@@ -6,6 +6,9 @@
 // default persist time
 #define GUI_PERSIST_TIME 3000
 
+// default minimum time between status line renders
+#define GUI_STATUS_TIME 100
+
 // mouse cursor persist tim
 #define GUI_CURSOR_TIME 5000
 
@@ -59,6 +62,7 @@ typedef struct gui_t
     int mouse_wheel;
     int persist_flags;
     int persist_time;
+    int status_time;
     uint64_t drive_persist_timer;
     uint64_t volume_persist_timer;
     uint64_t window_persist_timer;
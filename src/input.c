@@ -0,0 +1,279 @@
+//******************************************************************************
+//*                                  uBee512                                   *
+//*       An emulator for the Microbee Z80 ROM, FDD and HDD based models       *
+//*                                                                            *
+//*                                input module                                *
+//*                                                                            *
+//*                       Copyright (C) 2007-2016 uBee                         *
+//******************************************************************************
+//
+// Collects host input events.
+//
+// Events are normally polled with SDL_PollEvent() by the emulation thread.
+// If the input thread is enabled (--input-thread) SDL is initialised with
+// its own event thread and a separate input thread waits on the SDL event
+// queue, time stamps each event and places it into a single producer,
+// single consumer queue.  The emulation thread then drains the queue at
+// block boundaries without making any system calls.
+//
+//==============================================================================
+/*
+ *  uBee512 - An emulator for the Microbee Z80 ROM, FDD and HDD based models.
+ *  Copyright (C) 2007-2016 uBee
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+//==============================================================================
+// ChangeLog (most recent entries are at top)
+//==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Added input_wait_event() and input_idle() to block until an event
+//   arrives, used when paused or when the debugger has stopped execution.
+// - Created a new file to implement the input event queue.
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <SDL.h>
+#include <SDL_thread.h>
+
+#include "ubee512.h"
+#include "input.h"
+#include "support.h"
+
+//==============================================================================
+// structures and variables
+//==============================================================================
+input_t input;
+
+// The queue head is only written by the input thread and the tail only by
+// the emulation thread.
+static input_event_t input_queue[INPUT_QUEUE_SIZE];
+static volatile unsigned int input_head;
+static volatile unsigned int input_tail;
+
+extern emu_t emu;
+
+static int input_worker (void *data);
+
+//==============================================================================
+// Input initialise.
+//
+// SDL must have been initialised with SDL_INIT_EVENTTHREAD before the input
+// thread is started as SDL 1.2 only allows events to be pumped by the thread
+// that set the video mode otherwise.
+//
+//   pass: void
+// return: int                          0 if success, -1 if error
+//==============================================================================
+int input_init (void)
+{
+ input_head = 0;
+ input_tail = 0;
+ input.latency_max = 0;
+
+ if (! input.thread)
+    return 0;
+
+ input.terminate = 0;
+ input.mutex = SDL_CreateMutex();
+ input.ready = SDL_CreateCond();
+ input.workerthread = SDL_CreateThread(input_worker, NULL);
+ if (! input.workerthread)
+    {
+     xprintf("input_init: Unable to create the input thread\n");
+     input.thread = 0;
+     return -1;
+    }
+
+ return 0;
+}
+
+//==============================================================================
+// Input de-initialise.
+//
+// The input thread may be waiting on the SDL event queue so a user event is
+// pushed to wake it up.
+//
+//   pass: void
+// return: int                          0
+//==============================================================================
+int input_deinit (void)
+{
+ SDL_Event event;
+ int status;
+
+ if (input.workerthread)
+    {
+     input.terminate = 1;
+     event.type = SDL_USEREVENT;
+     SDL_PushEvent(&event);
+     SDL_WaitThread(input.workerthread, &status);
+     input.workerthread = NULL;
+     if (emu.verbose)
+        xprintf("input: maximum event queue latency %dmS\n",
+                input.latency_max);
+    }
+ if (input.ready)
+    SDL_DestroyCond(input.ready);
+ if (input.mutex)
+    SDL_DestroyMutex(input.mutex);
+ input.ready = NULL;
+ input.mutex = NULL;
+
+ return 0;
+}
+
+//==============================================================================
+// Input reset.
+//
+//   pass: void
+// return: int                          0
+//==============================================================================
+int input_reset (void)
+{
+ return 0;
+}
+
+//==============================================================================
+// Input thread.
+//
+// Waits for SDL events and places them into the input queue.  If the queue
+// is full the thread waits for the emulation thread to catch up rather than
+// losing events.
+//
+//   pass: void *data
+// return: int                          0
+//==============================================================================
+static int input_worker (void *data)
+{
+ SDL_Event event;
+ unsigned int head;
+
+ while (! input.terminate)
+    {
+     if (! SDL_WaitEvent(&event))
+        continue;
+     if (event.type == SDL_USEREVENT)
+        continue;
+
+     head = input_head;
+     while (((head - input_tail) >= INPUT_QUEUE_SIZE) && (! input.terminate))
+        SDL_Delay(1);
+
+     input_queue[head & (INPUT_QUEUE_SIZE - 1)].event = event;
+     input_queue[head & (INPUT_QUEUE_SIZE - 1)].ms = time_get_ms();
+     __sync_synchronize();      // entry must be visible before the head moves
+     input_head = head + 1;
+
+     // wake up the emulation thread if it's idle
+     SDL_LockMutex(input.mutex);
+     SDL_CondSignal(input.ready);
+     SDL_UnlockMutex(input.mutex);
+    }
+
+ return 0;
+}
+
+//==============================================================================
+// Get the next input event.
+//
+// When the input thread is running the event is taken from the input queue,
+// otherwise SDL_PollEvent() is used.  input.event_ms holds the time the
+// event was collected.
+//
+//   pass: SDL_Event *event             event returned
+// return: int                          1 if an event was returned, else 0
+//==============================================================================
+int input_poll_event (SDL_Event *event)
+{
+ unsigned int tail;
+ int latency;
+
+ if (! input.workerthread)
+    {
+     if (! SDL_PollEvent(event))
+        return 0;
+     input.event_ms = time_get_ms();
+     return 1;
+    }
+
+ tail = input_tail;
+ if (tail == input_head)
+    return 0;
+ __sync_synchronize();          // read the entry after seeing the head move
+
+ *event = input_queue[tail & (INPUT_QUEUE_SIZE - 1)].event;
+ input.event_ms = input_queue[tail & (INPUT_QUEUE_SIZE - 1)].ms;
+ __sync_synchronize();          // entry must be read before it is released
+ input_tail = tail + 1;
+
+ latency = (int)(time_get_ms() - input.event_ms);
+ if (latency > input.latency_max)
+    input.latency_max = latency;
+
+ return 1;
+}
+
+//==============================================================================
+// Wait for an input event.
+//
+// Blocks until an event is available or the timeout expires, the event is
+// not removed.  With the input thread this is a condition variable wait,
+// otherwise the SDL event queue is checked every 10mS which is the same rate
+// SDL_WaitEvent() uses.
+//
+//   pass: int timeout                  maximum time to wait in mS
+// return: int                          1 if an event is available, else 0
+//==============================================================================
+int input_wait_event (int timeout)
+{
+ uint64_t start;
+
+ if (input.workerthread)
+    {
+     SDL_LockMutex(input.mutex);
+     if (input_tail == input_head)
+        SDL_CondWaitTimeout(input.ready, input.mutex, timeout);
+     SDL_UnlockMutex(input.mutex);
+     return input_tail != input_head;
+    }
+
+ start = time_get_ms();
+ while (! SDL_PollEvent(NULL))
+    {
+     if ((time_get_ms() - start) >= timeout)
+        return 0;
+     SDL_Delay(10);
+    }
+
+ return 1;
+}
+
+//==============================================================================
+// Idle until there is something to do.  Called when the emulation is paused
+// or the debugger has stopped execution instead of spinning.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void input_idle (void)
+{
+ if (emu.display_context == EMU_OSD_CONTEXT)
+    input_wait_event(INPUT_IDLE_OSD_MS);
+ else
+    input_wait_event(INPUT_IDLE_MS);
+}
@@ -0,0 +1,43 @@
+/* INPUT Header */
+
+#ifndef HEADER_INPUT_H
+#define HEADER_INPUT_H
+
+#include <SDL.h>
+#include <SDL_thread.h>
+
+// number of entries in the input queue, must be a power of 2
+#define INPUT_QUEUE_SIZE 256
+
+// maximum time to block for in the idle (paused or stopped) states.  A
+// dialogue on the OSD needs regular updates for the flashing cursor.
+#define INPUT_IDLE_MS 250
+#define INPUT_IDLE_OSD_MS 20
+
+int input_init (void);
+int input_deinit (void);
+int input_reset (void);
+
+int input_poll_event (SDL_Event *event);
+int input_wait_event (int timeout);
+void input_idle (void);
+
+typedef struct input_event_t
+{
+ SDL_Event event;
+ uint64_t ms;                   /* host time the event was collected */
+}input_event_t;
+
+typedef struct input_t
+{
+ int thread;                    /* collect events on an input thread */
+ uint64_t event_ms;             /* collection time of the current event */
+ int latency_max;               /* worst case queue latency in mS */
+
+ SDL_Thread *workerthread;
+ SDL_mutex *mutex;
+ SDL_cond *ready;               /* signalled when an event is queued */
+ int terminate;                 /* set if the input thread is to terminate */
+}input_t;
+
+#endif     /* HEADER_INPUT_H */
@@ -31,6 +31,10 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - A key ready edge is now signalled with pio_notify() instead of calling
+//   pio_polling() directly.
+//
 // v4.6.0 - 4 May 2010, uBee
 // - Fixed bug in keytc_r() function where a 256TC model was being tested
 //   for instead of testing for models that use the TC keys (modelx.tckeys)
@@ -471,7 +475,7 @@ void keytc_key_event (int down)
           key_count++;
 
           key_256tc = B8(00000010); // a key is ready
-          pio_polling();  // needed for TC key interrupts to work well
+          pio_notify(PIO_B_INTRPEND);  // needed for TC key interrupts to work well
          }
      }
 }
@@ -595,7 +599,7 @@ uint16_t keytc_r (uint16_t port, struct z80_port_read *port_s)
  if (key_count)
     {
      key_256tc = B8(00000010);
-     pio_polling();
+     pio_notify(PIO_B_INTRPEND);
     }
  else
     key_256tc = 0;
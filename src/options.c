@@ -32,6 +32,21 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Added --db-screen, --screen-dump and --screen-dump-every options.
+// - Added --term option.
+// - Added --gui-status-time option.
+// - Added --video-raster option.
+// - Added --video-scale and --video-scanlines options.
+// - Added --video-diff option.
+// - Added '8i' to the --video-depth option for an indexed display surface.
+// - Added --record-video option.
+// - Added --screen-hash, --screenshot and --screenshot-every options for
+//   automated testing.
+// - Added --gl-text option to draw the text display with an OpenGL shader.
+// - Added --input-thread option to collect host events on a separate thread.
+// - Added --video-thread option to draw the display on a separate thread.
+//
 // v6.0.0 - 1 January 2017, K Duckmanton
 // - Moved functions relating to pixels and pixel colours to the vdu module.
 //
@@ -448,6 +463,7 @@
 #include "z80api.h"
 #include "crtc.h"
 #include "vdu.h"
+#include "scale.h"
 #include "crtc.h"
 #include "memmap.h"
 #include "keyb.h"
@@ -477,6 +493,9 @@
 #include "quickload.h"
 #include "sn76489an_core.h"
 #include "compumuse.h"
+#include "input.h"
+#include "capture.h"
+#include "term.h"
 
 #include "macros.h"
 
@@ -500,6 +519,8 @@ static struct option long_options[] =
  {"exit",           required_argument, 0, OPT_EXIT             + OPT_RUN},
  {"exit-check",     required_argument, 0, OPT_EXIT_CHECK       + OPT_RUN},
  {"gui-persist",    required_argument, 0, OPT_GUI_PERSIST      + OPT_RUN},
+ {"gui-status-time",required_argument, 0, OPT_GUI_STATUS_TIME  + OPT_RUN},
+ {"input-thread",   required_argument, 0, OPT_INPUT_THREAD     + OPT_Z  },
  {"keystd-mod",     required_argument, 0, OPT_KEYSTD_MOD       + OPT_RUN},
  {"lockfix-win32",  required_argument, 0, OPT_LOCKFIX_WIN32    + OPT_RUN},
  {"lockfix-x11",    required_argument, 0, OPT_LOCKFIX_X11      + OPT_RUN},
@@ -517,6 +538,7 @@ static struct option long_options[] =
  {"slashes",        required_argument, 0, OPT_SLASHES          + OPT_RUN},
  {"spad",           required_argument, 0, OPT_SPAD             + OPT_RUN},
  {"status",         required_argument, 0, OPT_STATUS           + OPT_RUN},
+ {"term",           required_argument, 0, OPT_TERM             + OPT_Z  },
  {"title",          required_argument, 0, OPT_TITLE            + OPT_RUN},
  {"varset",         required_argument, 0, OPT_VARSET           + OPT_RUN},
  {"varuset",        required_argument, 0, OPT_VARUSET          + OPT_RUN},
@@ -595,6 +617,7 @@ static struct option long_options[] =
  {"db-pushr",       no_argument,       0, OPT_DB_PUSHR         + OPT_RTO},
  {"db-saveb",       required_argument, 0, OPT_DB_SAVEB         + OPT_RTO},
  {"db-savem",       required_argument, 0, OPT_DB_SAVEM         + OPT_RTO},
+ {"db-screen",      no_argument,       0, OPT_DB_SCREEN        + OPT_RTO},
  {"db-setb",        required_argument, 0, OPT_DB_SETB          + OPT_RTO},
  {"db-setr",        required_argument, 0, OPT_DB_SETR          + OPT_RTO},
  {"db-setm",        required_argument, 0, OPT_DB_SETM          + OPT_RTO},
@@ -729,8 +752,20 @@ static struct option long_options[] =
  {"rgb-15-g",       required_argument, 0, OPT_RGB_15_G         + OPT_RUN},
  {"rgb-15-b",       required_argument, 0, OPT_RGB_15_B         + OPT_RUN},
 
+ {"screen-dump",    required_argument, 0, OPT_SCREEN_DUMP      + OPT_Z  },
+ {"screen-dump-every",required_argument, 0, OPT_SCREEN_DUMP_EVERY + OPT_Z  },
+ {"screen-hash",    required_argument, 0, OPT_SCREEN_HASH      + OPT_Z  },
+ {"screenshot",     required_argument, 0, OPT_SCREENSHOT       + OPT_Z  },
+ {"screenshot-every",required_argument, 0, OPT_SCREENSHOT_EVERY + OPT_Z  },
+ {"record-video",   required_argument, 0, OPT_RECORD_VIDEO     + OPT_Z  },
+
  {"video",          required_argument, 0, OPT_VIDEO            + OPT_RUN},
  {"video-depth",    required_argument, 0, OPT_VIDEO_DEPTH      + OPT_Z  },
+ {"video-diff",     required_argument, 0, OPT_VIDEO_DIFF       + OPT_Z  },
+ {"video-raster",   required_argument, 0, OPT_VIDEO_RASTER     + OPT_Z  },
+ {"video-scale",    required_argument, 0, OPT_VIDEO_SCALE      + OPT_Z  },
+ {"video-scanlines",required_argument, 0, OPT_VIDEO_SCANLINES  + OPT_Z  },
+ {"video-thread",   required_argument, 0, OPT_VIDEO_THREAD     + OPT_Z  },
  {"video-type",     required_argument, 0, OPT_VIDEO_TYPE       + OPT_Z  },
 
 #ifdef USE_OPENGL
@@ -741,6 +776,7 @@ static struct option long_options[] =
  {"gl-filter-max",  required_argument, 0, OPT_GL_FILTER_MAX    + OPT_RUN},
  {"gl-filter-win",  required_argument, 0, OPT_GL_FILTER_WIN    + OPT_RUN},
  {"gl-max",         required_argument, 0, OPT_GL_MAX           + OPT_Z  },
+ {"gl-text",        required_argument, 0, OPT_GL_TEXT          + OPT_Z  },
  {"gl-vsync",       required_argument, 0, OPT_GL_VSYNC         + OPT_Z  },
  {"gl-winpct",      required_argument, 0, OPT_GL_WINPCT        + OPT_Z  },
  {"gl-winpix",      required_argument, 0, OPT_GL_WINPIX        + OPT_Z  },
@@ -1072,6 +1108,9 @@ extern model_t model_data[];
 extern model_t modelx;
 extern model_custom_t modelc;
 extern crtc_t crtc;
+extern capture_t capture;
+extern term_t term;
+extern input_t input;
 extern fdc_t fdc;
 extern gui_t gui;
 extern osd_t osd;
@@ -1434,6 +1473,17 @@ TITLESTRING"\n"
 "  --gui-persist=n         Set the persist time in milliseconds for values that\n"
 "                          appear on the status line, default is 3000mS.\n"
 "\n"
+"  --gui-status-time=n     Set the minimum time in milliseconds between status\n"
+"                          line updates. n may be 0-10000, default is 100mS.\n"
+"                          Changes made in between, such as drive activity,\n"
+"                          are shown at the next update.\n"
+"\n"
+"  --input-thread=x        Collect keyboard, mouse and joystick events on a\n"
+"                          separate thread. x=on to enable, x=off to disable.\n"
+"                          Default is disabled. This requires SDL event thread\n"
+"                          support and is ignored if the platform does not\n"
+"                          provide it.\n"
+"\n"
 "  --keystd-mod=args       Set a standard keyboard behaviour modifier flag.\n"
 "                          These flags provide workarounds when emulating the\n"
 "                          6545 light pen keys.\n"
@@ -1564,6 +1614,15 @@ TITLESTRING"\n"
 "                          vol    (-+) always show volume level.\n"
 "                          win    (-+) always show window size.\n"
 "\n"
+"  --term=x                Draw the text screen on the terminal that started\n"
+"                          the emulator using ANSI escape sequences and take\n"
+"                          keys from it. x=on to enable, x=off to disable.\n"
+"                          Only changed characters are sent. PCG characters\n"
+"                          are shown as '#'. Press CTRL+] then 'q' to exit.\n"
+"                          Messages are not written to stdout while enabled.\n"
+"                          Use with --video=off and SDL_VIDEODRIVER=dummy to\n"
+"                          run without a display. Default is disabled.\n"
+"\n"
 "  --title=name            Define the customised title name to be used when\n"
 "                          '+title' is used in the --status option.\n"
 "\n"
@@ -1813,6 +1872,9 @@ TITLESTRING"\n"
 "                          help for more information.\n"
 "  --db-savem=s,f,file     Save memory starting at address 's' and finishing at\n"
 "                          'f' to a file.\n"
+"  --db-screen             Show the visible text screen decoded from video\n"
+"                          memory. PCG characters are shown as '#' unless\n"
+"                          blank.\n"
 "\n"
 "  --db-setb=t,b,o,v[,v..] Set memory in bank type 't', bank 'b' at offset 'o'\n"
 "                          with value(s) 'v'.\n"
@@ -2110,6 +2172,45 @@ TITLESTRING"\n"
 "                          nn is the colour value (00-15), x is the gun colour\n"
 "                          ('r', 'g', 'b'). The level value is 0-255.\n"
 "\n"
+"  --screen-dump=file      Write the visible text screen decoded from video\n"
+"                          memory to file, one line per row. The file is\n"
+"                          checked every --screen-dump-every frames, only\n"
+"                          rewritten if the text has changed and is replaced\n"
+"                          in one step so it's never seen part written.\n"
+"                          PCG characters are written as '#' unless blank.\n"
+"\n"
+"  --screen-dump-every=n   Set the number of frames between --screen-dump\n"
+"                          checks. Default is 50.\n"
+"\n"
+"  --screen-hash=n         Report a hash of the visible display every n frames\n"
+"                          and at exit, if n is 0 only at exit. The report is\n"
+"                          'screen-hash: frame hash' where hash is a 64 bit\n"
+"                          hexadecimal value of the display's RGB pixels, one\n"
+"                          pixel per CRTC pixel.\n"
+"\n"
+"  --screenshot=file       Write an image of the visible display to file at\n"
+"                          exit. A file ending in '.png' is written as a PNG\n"
+"                          image, otherwise as a binary PPM image.\n"
+"\n"
+"  --screenshot-every=n,dir[,format]\n"
+"                          Write an image of the visible display every n\n"
+"                          frames to directory dir. The files are named\n"
+"                          ubee512-nnnnnnnn with a sequence number. format may\n"
+"                          be 'png' (default) or 'ppm'.\n"
+"\n"
+"  --record-video=file     Record every emulated frame of the visible display\n"
+"                          to file, one pixel per CRTC pixel. A file ending in\n"
+"                          '.y4m' is written as YUV4MPEG2 video (4:4:4),\n"
+"                          otherwise as raw 24 bit RGB frames described by\n"
+"                          file.txt. Frames are dropped rather than slowing\n"
+"                          the emulation if the file can't be written fast\n"
+"                          enough.\n"
+"\n"
+"                          Images and video are written by separate threads.\n"
+"                          These options may be used without a display by\n"
+"                          setting the environment variable\n"
+"                          SDL_VIDEODRIVER=dummy.\n"
+"\n"
 "  --video=x               Video initial start state. x=on to enable, x=off to\n"
 "                          to disable. Default is enabled.\n"
 "\n"
@@ -2122,6 +2223,36 @@ TITLESTRING"\n"
 "                          8gs : 8 bit grey scale.\n"
 "                          16  : 16 bit colour.\n"
 "                          32  : 32 bit colour.\n"
+"                          8i  : 8 bit indexed colour. Colour, monitor and\n"
+"                                intensity changes only set the palette.\n"
+"\n"
+"  --video-diff=x          Find changed screen, attribute and colour RAM once\n"
+"                          per frame by comparing with a copy instead of on\n"
+"                          each Z80 write. x=on to enable, x=off to disable.\n"
+"                          This may help programs that write the same screen\n"
+"                          area many times a frame. Default is disabled.\n"
+"\n"
+"  --video-raster=x        Draw each frame in scan line bands when the display\n"
+"                          start address, scan lines per row or colour port\n"
+"                          is changed part way through a frame, for split\n"
+"                          screen effects. x=on to enable, x=off to disable.\n"
+"                          Frames without such changes are drawn as normal.\n"
+"                          Default is disabled.\n"
+"\n"
+"  --video-scale=n         Scale the display up by a whole number factor when\n"
+"                          using SDL rendering. n may be 1 to 4, the default\n"
+"                          is 1. The changed parts of the display are scaled\n"
+"                          to the window as each frame is presented.\n"
+"\n"
+"  --video-scanlines=x     Darken every scaled row's last line for a scan line\n"
+"                          effect when --video-scale is greater than 1. x=on\n"
+"                          to enable, x=off to disable. Not available with 8\n"
+"                          bit depths. Default is disabled.\n"
+"\n"
+"  --video-thread=x        Draw the display on a separate thread. x=on to\n"
+"                          enable, x=off to disable. The Z80 emulation carries\n"
+"                          on while the previous frame is being drawn which\n"
+"                          may help on multi-core hosts. Default is disabled.\n"
 "\n"
 "  --video-type=type       Video type. The default type used is SDL hw rendering\n"
 "                          Other types may improve or degrade performance, i.e.\n"
@@ -2256,6 +2387,12 @@ TITLESTRING"\n"
 "                          --fullscreen option. Default is off. This option is\n"
 "                          currently not supported on Windows machines.\n"
 "\n"
+"  --gl-text=x             Draw the text display on the GPU with a shader.\n"
+"                          x=on to enable, x=off to disable. Default is off.\n"
+"                          Requires OpenGL 2.0, the normal texture rendering\n"
+"                          is used while the OSD is displayed or when\n"
+"                          --video-raster is enabled.\n"
+"\n"
 "  --gl-vsync=x            Vsync: swap buffers every n'th retrace. x=off to\n"
 "                          disable, x=on to enable. Default is enabled.\n"
 "\n"
@@ -3690,6 +3827,12 @@ static void options_control (int c)
      case OPT_GUI_PERSIST :
         set_int_from_arg(&gui.persist_time, 1, MAXINT);
         break;
+     case OPT_GUI_STATUS_TIME :
+        set_int_from_arg(&gui.status_time, 0, 10000);
+        break;
+     case OPT_INPUT_THREAD :
+        set_int_from_list(&input.thread, offon_args);
+        break;
      case OPT_KEYSTD_MOD :
         while (1)
            {
@@ -3776,6 +3919,9 @@ static void options_control (int c)
             gui_proc_status_args(res, pf);
            }
         break;
+     case OPT_TERM :
+        set_int_from_list(&term.enable, offon_args);
+        break;
      case OPT_TITLE :
         strncpy(gui.title, e_optarg, sizeof(gui.title));
         gui.title[sizeof(gui.title)-1] = 0;
@@ -4195,6 +4341,9 @@ static void options_debugging (int c)
         if (z80debug_save_memory(e_optarg) == -1)
            param_error_mesg();
         break;
+     case OPT_DB_SCREEN :
+        z80debug_dump_screen();
+        break;
 
      case OPT_DB_SETB :
         if (z80debug_set_bank(e_optarg) == -1)
@@ -4462,6 +4611,7 @@ static void options_display (int c)
   "8gs",
   "16",
   "32",
+  "8i",
   ""
  };
 
@@ -4496,8 +4646,8 @@ static void options_display (int c)
            crtc.monitor = x;
         if (emu.runmode)
            {
-            vdu_setcolourtable();
-            crtc_set_redraw();
+            if (vdu_setcolourtable())
+               crtc_set_redraw();
            }
         break;
 
@@ -4579,12 +4729,52 @@ static void options_display (int c)
         col_table_p[(c - OPT_RGB_00_R) / 3][2 - ((c - OPT_RGB_00_R) % 3)] = x;
         break;
 
+     case OPT_SCREEN_DUMP :
+        strncpy(capture.dump, e_optarg, sizeof(capture.dump));
+        capture.dump[sizeof(capture.dump) - 1] = 0;
+        break;
+     case OPT_SCREEN_DUMP_EVERY :
+        set_int_from_arg(&capture.dump_every, 1, MAXINT);
+        break;
+     case OPT_SCREEN_HASH :
+        if (set_int_from_arg(&capture.hash, 0, MAXINT) == -1)
+           break;
+        capture.hash_used = 1;
+        break;
+     case OPT_SCREENSHOT :
+        strncpy(capture.file, e_optarg, sizeof(capture.file));
+        capture.file[sizeof(capture.file) - 1] = 0;
+        break;
+     case OPT_SCREENSHOT_EVERY :
+        if (capture_set_every(e_optarg) == -1)
+           param_error_mesg();
+        break;
+     case OPT_RECORD_VIDEO :
+        strncpy(capture.record, e_optarg, sizeof(capture.record));
+        capture.record[sizeof(capture.record) - 1] = 0;
+        break;
+
      case OPT_VIDEO :
         set_int_from_list(&crtc.video, offon_args);
         break;
      case OPT_VIDEO_DEPTH :
         set_int_from_list(&video.depth, video_depth_args);
         break;
+     case OPT_VIDEO_DIFF :
+        set_int_from_list(&video.diff, offon_args);
+        break;
+     case OPT_VIDEO_RASTER :
+        set_int_from_list(&crtc.raster, offon_args);
+        break;
+     case OPT_VIDEO_SCALE :
+        set_int_from_arg(&video.scale, 1, SCALE_MAX);
+        break;
+     case OPT_VIDEO_SCANLINES :
+        set_int_from_list(&video.scanlines, offon_args);
+        break;
+     case OPT_VIDEO_THREAD :
+        set_int_from_list(&video.thread, offon_args);
+        break;
      case OPT_VIDEO_TYPE :
 #ifndef USE_OPENGL
         if (strcmp(e_optarg, "gl") == 0)
@@ -4625,6 +4815,9 @@ static void options_display (int c)
         set_int_from_list(&video.max, offon_args);
 #endif
         break;
+     case OPT_GL_TEXT :
+        set_int_from_list(&video.gl_text, offon_args);
+        break;
      case OPT_GL_VSYNC :
         set_int_from_list(&video.vsync, offon_args);
         break;
@@ -4844,8 +5037,8 @@ static void options_model (int c)
             crtc.monitor = string_search(monitor_args, "g");  // can't be an error
             if (emu.runmode)
                {
-                vdu_setcolourtable();
-                crtc_set_redraw();
+                if (vdu_setcolourtable())
+                   crtc_set_redraw();
                }
            }
         else
@@ -54,6 +54,8 @@ enum
  OPT_EXIT,
  OPT_EXIT_CHECK,
  OPT_GUI_PERSIST,
+ OPT_GUI_STATUS_TIME,
+ OPT_INPUT_THREAD,
  OPT_KEYSTD_MOD,
  OPT_LOCKFIX_WIN32,
  OPT_LOCKFIX_X11,
@@ -71,6 +73,7 @@ enum
  OPT_SLASHES,
  OPT_SPAD,
  OPT_STATUS,
+ OPT_TERM,
  OPT_TITLE,
  OPT_VARSET,
  OPT_VARUSET,
@@ -149,6 +152,7 @@ enum
  OPT_DB_PUSHR,
  OPT_DB_SAVEB,
  OPT_DB_SAVEM,
+ OPT_DB_SCREEN,
  OPT_DB_SETB,
  OPT_DB_SETM,
  OPT_DB_SETR,
@@ -289,8 +293,20 @@ enum
  OPT_RGB_15_G,
  OPT_RGB_15_B,
 
+ OPT_SCREEN_DUMP,
+ OPT_SCREEN_DUMP_EVERY,
+ OPT_SCREEN_HASH,
+ OPT_SCREENSHOT,
+ OPT_SCREENSHOT_EVERY,
+ OPT_RECORD_VIDEO,
+
  OPT_VIDEO,
  OPT_VIDEO_DEPTH,
+ OPT_VIDEO_DIFF,
+ OPT_VIDEO_RASTER,
+ OPT_VIDEO_SCALE,
+ OPT_VIDEO_SCANLINES,
+ OPT_VIDEO_THREAD,
  OPT_VIDEO_TYPE,
 
 #ifdef USE_OPENGL
@@ -300,6 +316,7 @@ enum
  OPT_GL_FILTER_MAX,
  OPT_GL_FILTER_WIN,
  OPT_GL_MAX,
+ OPT_GL_TEXT,
  OPT_GL_VSYNC,
  OPT_GL_WINPCT,
  OPT_GL_WINPIX
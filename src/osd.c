@@ -31,6 +31,22 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - The console text is now a ring of lines with a scroll back of
+//   OSD_CON_LINES lines viewed with PageUp and PageDown.  Only the console
+//   rows that differ from those last drawn and the cursor cell are drawn
+//   again when text is written.  While scrolled back the view is moved by
+//   the number of rows written text takes, wrapped lines included.
+// - Dialogues are now drawn on a canvas surface and blitted to the display.
+//   Only boxes that have changed since they were last drawn are drawn
+//   again and the console cursor cell is flashed on its own.  Text is
+//   blitted from the font drawn once per colour pair and XPM images are
+//   converted to surfaces once, the caches are flushed when the scheme or
+//   display format changes.  Mouse highlighting and console output no
+//   longer force a redraw of the whole display.
+// - osd_dialogue() waits for the video render thread to become idle before
+//   the dialogue is drawn over the display.
+//
 // v6.0.0 - 1 January 2017, K Duckmanton
 // - crtc.yscale is now video.yscale; video_renderer() is now video_render()
 //   to match video.c
@@ -389,6 +405,29 @@ static uint64_t msecs_before;
 static font_t font;
 static SDL_PixelFormat *spf;
 
+// Dialogues are drawn on a canvas the same size and format as the display
+// surface and composed onto the display with a blit.  Only the boxes that
+// differ from the last drawn state are drawn again.
+static SDL_Surface *canvas;
+static SDL_Surface *target;
+static int canvas_yscale;
+static osd_glyphs_t glyph_cache[OSD_GLYPH_CACHES];
+static int glyph_next;
+static osd_xpm_t xpm_cache[OSD_XPM_CACHES];
+static int xpm_next;
+static mbox_t drawn;
+static mbox_t *drawn_mbox;
+static int drawn_focus;
+static int drawn_text_gen;
+static int redraw_all;
+static int text_gen;
+static osd_cursor_t cursor;
+
+// console text and the rows of it last drawn
+static osd_con_t con;
+static char con_shown[OSD_CON_ROWS][OSD_CON_LINE_MAX];
+static int con_shown_len[OSD_CON_ROWS];
+
 static char command[1000];
 static int cmd_length;
 static int cmd_putpos;
@@ -409,6 +448,9 @@ extern uint8_t fontdata[];
 
 static void osd_dialogue (int dialogue);
 static int osd_get_pending (void);
+static void set_box_col (box_t *box, int *bgc, int *fgc);
+static void set_text_col (box_t *box, int *bgc, int *fgc);
+static void osd_cache_flush (void);
 
 //==============================================================================
 // dialogues text
@@ -466,7 +508,8 @@ static char dialogue_about[] =
  "         www.microbee-mspp.org.au\n"
 };
 
-static char dialogue_console[CONSOLE_SIZE+1];
+// the console text is held in 'con', this only identifies the console box
+static char dialogue_console[1];
 static char dialogue_shared[SHARED_SIZE+1];
 
 //==============================================================================
@@ -973,6 +1016,7 @@ int osd_init (void)
 //==============================================================================
 int osd_deinit (void)
 {
+ osd_cache_flush();
  return 0;
 }
 
@@ -987,6 +1031,115 @@ int osd_reset (void)
  return 0;
 }
 
+//==============================================================================
+// Create a surface in the display surface's format.
+//
+//   pass: int w
+//         int h
+// return: SDL_Surface *                surface or NULL if error
+//==============================================================================
+static SDL_Surface *osd_create_surface (int w, int h)
+{
+ SDL_PixelFormat *fmt = screen->format;
+ SDL_Surface *s;
+
+ s = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, fmt->BitsPerPixel,
+                          fmt->Rmask, fmt->Gmask, fmt->Bmask, 0);
+ if (s && fmt->palette)
+    SDL_SetColors(s, fmt->palette->colors, 0, fmt->palette->ncolors);
+
+ return s;
+}
+
+//==============================================================================
+// Free the cached glyphs and XPM images and the canvas.  Called when the
+// scheme changes or the display surface is no longer the same format.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void osd_cache_flush (void)
+{
+ int i;
+
+ for (i = 0; i < OSD_GLYPH_CACHES; i++)
+    {
+     if (glyph_cache[i].s)
+        SDL_FreeSurface(glyph_cache[i].s);
+     glyph_cache[i].s = NULL;
+    }
+ for (i = 0; i < OSD_XPM_CACHES; i++)
+    {
+     if (xpm_cache[i].s)
+        SDL_FreeSurface(xpm_cache[i].s);
+     xpm_cache[i].s = NULL;
+     xpm_cache[i].xpm = NULL;
+    }
+ if (canvas)
+    SDL_FreeSurface(canvas);
+ canvas = NULL;
+ drawn_mbox = NULL;
+}
+
+//==============================================================================
+// Make sure the canvas matches the display surface, it's created again if
+// the size, format, palette or Y scale has changed.
+//
+//   pass: void
+// return: int                          1 if the canvas is new, else 0
+//==============================================================================
+static int osd_canvas_check (void)
+{
+ SDL_PixelFormat *fmt = screen->format;
+ SDL_PixelFormat *cfmt;
+
+ if (canvas)
+    {
+     cfmt = canvas->format;
+     if ((canvas->w == screen->w) && (canvas->h == screen->h) &&
+        (cfmt->BitsPerPixel == fmt->BitsPerPixel) &&
+        (cfmt->Rmask == fmt->Rmask) && (cfmt->Gmask == fmt->Gmask) &&
+        (cfmt->Bmask == fmt->Bmask) && (canvas_yscale == video.yscale) &&
+        ((! fmt->palette) ||
+        ((cfmt->palette->ncolors == fmt->palette->ncolors) &&
+        (memcmp(cfmt->palette->colors, fmt->palette->colors,
+                fmt->palette->ncolors * sizeof(SDL_Color)) == 0))))
+        return 0;
+    }
+
+ osd_cache_flush();
+ canvas = osd_create_surface(screen->w, screen->h);
+ canvas_yscale = video.yscale;
+ if (! canvas)
+    xprintf("osd_canvas_check: Unable to create the OSD canvas\n");
+
+ return 1;
+}
+
+//==============================================================================
+// Fill a rectangle.
+//
+//   pass: int x1                       left
+//         int y1                       top
+//         int x2                       right (inclusive)
+//         int y2                       bottom (inclusive)
+//         int col                      mapped colour
+// return: void
+//==============================================================================
+static void fill_rect (int x1, int y1, int x2, int y2, int col)
+{
+ SDL_Rect r;
+
+ if ((x2 < x1) || (y2 < y1))
+    return;
+
+ r.x = x1;
+ r.y = y1 * video.yscale;
+ r.w = (x2 - x1) + 1;
+ r.h = ((y2 - y1) + 1) * video.yscale;
+ SDL_FillRect(target, &r, col);
+}
+
 //==============================================================================
 // Draw a single pixel
 //
@@ -997,17 +1150,65 @@ int osd_reset (void)
 //==============================================================================
 static void put_pixel (int x, int y, int col)
 {
- if (video.yscale == 2)
+ fill_rect(x, y, x, y, col);
+}
+
+//==============================================================================
+// Get the font drawn in a pair of colours.  The font is drawn once for each
+// colour pair and kept until the cache entry is reused.
+//
+//   pass: int fgc                      mapped foreground colour
+//         int bgc                      mapped background colour
+// return: SDL_Surface *                font surface or NULL if error
+//==============================================================================
+static SDL_Surface *osd_glyphs (int fgc, int bgc)
+{
+ osd_glyphs_t *gp;
+ SDL_Rect r;
+ int pixels;
+ int c, x, y;
+ int i;
+
+ for (i = 0; i < OSD_GLYPH_CACHES; i++)
     {
-     video_putpixel(x, y*2,   col);
-     video_putpixel(x, y*2+1, col);
+     gp = &glyph_cache[i];
+     if (gp->s && (gp->fgc == fgc) && (gp->bgc == bgc))
+        return gp->s;
     }
- else
-    video_putpixel(x, y, col);
+
+ gp = &glyph_cache[glyph_next];
+ if (++glyph_next >= OSD_GLYPH_CACHES)
+    glyph_next = 0;
+ if (gp->s)
+    SDL_FreeSurface(gp->s);
+ gp->s = osd_create_surface(OSD_FONT_GLYPHS * OSD_FONT_WIDTH,
+                            OSD_FONT_DEPTH * video.yscale);
+ if (! gp->s)
+    return NULL;
+ gp->fgc = fgc;
+ gp->bgc = bgc;
+
+ SDL_FillRect(gp->s, NULL, bgc);
+ r.w = 1;
+ r.h = video.yscale;
+ for (i = 0, c = 0; c < OSD_FONT_GLYPHS; c++)
+    for (y = 0; y < OSD_FONT_DEPTH; y++)
+       {
+        pixels = fontdata[i++];
+        for (x = 0; x < OSD_FONT_WIDTH; x++, pixels <<= 1)
+           if (pixels & 0x80)
+              {
+               r.x = c * OSD_FONT_WIDTH + x;
+               r.y = y * video.yscale;
+               SDL_FillRect(gp->s, &r, fgc);
+              }
+       }
+
+ return gp->s;
 }
 
 //==============================================================================
-// Draw an XPM image.
+// Convert an XPM image to a surface.
 //
 // This implementation assumes single ASCII characters in the XPM file and so
 // is limited to 126 unique colours.  All data is assumed to be of type 'c'.
@@ -1015,14 +1216,17 @@ static void put_pixel (int x, int y, int col)
 // Additional colour constants (see rgb.txt on a Little Endian X11 system)
 // may need to be added to the x11_rgb_col table.
 //
+// The surface has an alpha channel so transparent pixels are left alone
+// when it's blitted.
+//
 //   pass: char *xpm
-//         int x
-//         int y
-// return: void
+// return: SDL_Surface *                surface or NULL if error
 //==============================================================================
-static void put_xpm (char *xpm[], int x, int y)
+static SDL_Surface *xpm_to_surface (char *xpm[])
 {
- int col_table[128];
+ SDL_Surface *s;
+ uint32_t col_table[128];
+ uint32_t *p;
  int width = 0;
  int height = 0;
  int colours = 0;
@@ -1032,7 +1236,6 @@ static void put_xpm (char *xpm[], int x, int y)
  int col;
  int xpm_x;
  int xpm_y;
- int put_x;
  int i;
  int z;
 
@@ -1057,26 +1260,84 @@ static void put_xpm (char *xpm[], int x, int y)
             }
         }
      if (col == -1)
-        col_table[col_char] = -1;
+        col_table[col_char] = 0;
      else
-        col_table[col_char] = SDL_MapRGB(spf, (col & 0x00ff0000) >> 16,
-                                        (col & 0x0000ff00) >> 8,
-                                        (col & 0x000000ff));
+        col_table[col_char] = 0xff000000 | (col & 0x00ffffff);
     }
 
- // draw the image
- for (xpm_y = 0; xpm_y < height; xpm_y++)
+ s = SDL_CreateRGBSurface(SDL_SWSURFACE, width, height * video.yscale, 32,
+                          0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+ if (! s)
+    return NULL;
+
+ for (xpm_y = 0; xpm_y < height * video.yscale; xpm_y++)
     {
-     put_x = x;
+     p = (uint32_t *)((uint8_t *)s->pixels + xpm_y * s->pitch);
      for (xpm_x = 0; xpm_x < width; xpm_x++)
-        {
-         if (col_table[(int)xpm[i][xpm_x]] != -1)
-            put_pixel(put_x, y, col_table[(int)xpm[i][xpm_x]]);
-         put_x++;
-        }
-     i++;
-     y++;
+        *p++ = col_table[(int)xpm[i + xpm_y / video.yscale][xpm_x]];
     }
+
+ return s;
+}
+
+//==============================================================================
+// Draw an XPM image.
+//
+// The image is converted to a surface the first time it's drawn with the
+// current colour line, XPM widget colours are changed by pointing their
+// colour line at another string.
+//
+//   pass: char *xpm
+//         int x
+//         int y
+// return: void
+//==============================================================================
+static void put_xpm (char *xpm[], int x, int y)
+{
+ osd_xpm_t *xp = NULL;
+ SDL_Rect r;
+ int i;
+
+ for (i = 0; i < OSD_XPM_CACHES; i++)
+    if ((xpm_cache[i].xpm == xpm) && (xpm_cache[i].colour == xpm[1]))
+       {
+        xp = &xpm_cache[i];
+        break;
+       }
+
+ if (! xp)
+    {
+     xp = &xpm_cache[xpm_next];
+     if (++xpm_next >= OSD_XPM_CACHES)
+        xpm_next = 0;
+     if (xp->s)
+        SDL_FreeSurface(xp->s);
+     xp->xpm = xpm;
+     xp->colour = xpm[1];
+     xp->s = xpm_to_surface(xpm);
+    }
+
+ if (! xp->s)
+    return;
+
+ r.x = x;
+ r.y = y * video.yscale;
+ SDL_BlitSurface(xp->s, NULL, target, &r);
+}
+
+//==============================================================================
+// Set the XPM widget colours from the scheme.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void osd_set_xpm_colours (void)
+{
+ sprintf(colour_xpm_hl, "  c #%6X", osdsch->widget_xpm_hl);
+ sprintf(colour_xpm_ll, "  c #%6X", osdsch->widget_xpm_ll);
+
+ // the cached images were drawn with the old colours
+ osd_cache_flush();
 }
 
 //==============================================================================
@@ -1121,70 +1382,359 @@ static int dialogue_depth (void)
 //==============================================================================
 static void write_char_to_osd (int c)
 {
- int x;
- int y;
- int i;
- int pixels;
+ SDL_Surface *glyphs;
+ SDL_Rect srcrect;
+ SDL_Rect dstrect;
 
- i = font.depth * c;
-
- for (y = 0; y < font.depth; y++)
+ glyphs = osd_glyphs(font.fgc, font.bgc);
+ if (glyphs)
     {
-     pixels = font.data[i++];
-
-     for (x = 0; x < font.width; x++)
-        {
-         if (pixels & 0x80)
-            put_pixel(font.x_s + x, font.y_s + y, font.fgc);
-         else
-            put_pixel(font.x_s + x, font.y_s + y, font.bgc);
-         pixels <<= 1;
-        }
+     srcrect.x = (c & (OSD_FONT_GLYPHS - 1)) * OSD_FONT_WIDTH;
+     srcrect.y = 0;
+     srcrect.w = OSD_FONT_WIDTH;
+     srcrect.h = OSD_FONT_DEPTH * video.yscale;
+     dstrect.x = font.x_s;
+     dstrect.y = font.y_s * video.yscale;
+     SDL_BlitSurface(glyphs, &srcrect, target, &dstrect);
     }
 
  font.x_s += font.width;
 }
 
 //==============================================================================
-// Update cursor in the OSD.
+// Get the cursor flashing state.
 //
 //   pass: box_t *box                   dialogue box
+// return: int                          1 if the cursor is shown, else 0
+//==============================================================================
+static int cursor_phase (box_t *box)
+{
+ return (! box->cursor_rate) || ((time_get_ms() / box->cursor_rate) & 0x01);
+}
+
+//==============================================================================
+// Console text.
+//
+// The console keeps its text as a ring of lines rather than in a character
+// buffer so the rows shown can be found without scanning the text, lines
+// wider than the box are wrapped when displayed.  The rows last drawn are
+// kept and only rows that differ are drawn again along with the cursor
+// cell, the rest of the dialogue is left alone.
+//==============================================================================
+
+//==============================================================================
+// Get the number of display rows a console line needs.  The last line
+// always has room for the cursor after the text.
+//
+//   pass: int line                     console line
+//         int w                        text width of the box
+// return: int                          number of rows
+//==============================================================================
+static int con_line_rows (int line, int w)
+{
+ if (line == con.last)
+    return con.len[line] / w + 1;
+ if (! con.len[line])
+    return 1;
+ return (con.len[line] + w - 1) / w;
+}
+
+//==============================================================================
+// Start a new console line.
+//
+//   pass: void
 // return: void
 //==============================================================================
-static void update_cursor (box_t *box)
+static void con_newline (void)
 {
- int x;
- int y;
+ con.last = (con.last + 1) & (OSD_CON_LINES - 1);
+ con.len[con.last] = 0;
+ if (con.lines < OSD_CON_LINES)
+    con.lines++;
+}
 
- int curs_x;
- int curs_y;
+//==============================================================================
+// Get the number of display rows from a console line to the last line.
+//
+//   pass: int line                     first console line
+//         int w                        text width of the box
+// return: int                          number of rows
+//==============================================================================
+static int con_tail_rows (int line, int w)
+{
+ int rows = 0;
 
- // only want cursor for console text
- if (box->text != dialogue_console)
-    return;
+ for (;;)
+    {
+     rows += con_line_rows(line, w);
+     if (line == con.last)
+        return rows;
+     line = (line + 1) & (OSD_CON_LINES - 1);
+    }
+}
 
- if (font.x_s + (font.width-1) > box->text_posx_f)
+//==============================================================================
+// Write a character to the console text.
+//
+// If the view is scrolled back it is moved by the number of rows the text
+// below it has grown or shrunk by so it stays on the same rows.  A character
+// only changes the rows of the last line and the line before it (a new line
+// or a backspace joining lines).
+//
+//   pass: box_t *box                   console main box
+//         int c                        printable or control character
+// return: void
+//==============================================================================
+static void con_putchar (box_t *box, int c)
+{
+ int first = con.last;
+ int rows = 0;
+ int w;
+
+ if (! con.lines)
+    con.lines = 1;
+
+ w = box->text_width;
+ if (w > OSD_CON_LINE_MAX)
+    w = OSD_CON_LINE_MAX;
+ if (w < 1)
+    w = 0;
+
+ if (con.scroll && w)
     {
-     curs_y = font.y_s + font.depth;
-     curs_x = font.xorig;
+     if (con.lines > 1)
+        first = (con.last - 1) & (OSD_CON_LINES - 1);
+     rows = con_tail_rows(first, w);
     }
- else
+
+ switch (c)
     {
-     curs_x = font.x_s;
-     curs_y = font.y_s;
+     case '\b' : // destructive backspace, joins the previous line if empty
+        if (con.len[con.last])
+           con.len[con.last]--;
+        else
+           if (con.lines > 1)
+              {
+               con.last = (con.last - 1) & (OSD_CON_LINES - 1);
+               con.lines--;
+              }
+        break;
+     case '\n' :
+        con_newline();
+        break;
+     default :
+        if (c < ' ')
+           break;
+        if (con.len[con.last] == OSD_CON_LINE_MAX)
+           con_newline();
+        con.text[con.last][con.len[con.last]++] = c;
+        break;
     }
 
- if (curs_y + (font.depth-1) > box->text_posy_f)
+ if (con.scroll && w)
+    {
+     con.scroll += con_tail_rows(first, w) - rows;
+     if (con.scroll < 0)
+        con.scroll = 0;
+    }
+}
+
+//==============================================================================
+// Scroll the console view back (positive) or forward (negative).
+//
+//   pass: box_t *box                   console main box
+//         int rows                     rows to scroll
+// return: void
+//==============================================================================
+static void con_scroll (box_t *box, int rows)
+{
+ int total = 0;
+ int line = con.last;
+ int i;
+
+ if ((box->text_width < 1) || (box->text_depth < 1))
     return;
 
- for (y = 0; y < font.depth; y++)
+ for (i = 0; i < con.lines; i++)
     {
-     if ((! box->cursor_rate) || ((time_get_ms() / box->cursor_rate) & 0x01))
+     total += con_line_rows(line, box->text_width);
+     line = (line - 1) & (OSD_CON_LINES - 1);
+    }
+
+ con.scroll += rows;
+ if (con.scroll > total - box->text_depth)
+    con.scroll = total - box->text_depth;
+ if (con.scroll < 0)
+    con.scroll = 0;
+
+ crtc.update = 1;
+}
+
+//==============================================================================
+// Find the console rows to be displayed, the bottom row shown is con.scroll
+// rows up from the last row.
+//
+//   pass: int w                        text width of the box
+//         int depth                    text depth of the box
+//         char *rowp[]                 text returned for each row
+//         int rowlen[]                 length returned for each row
+//         int *cur_row                 cursor row, -1 if not shown
+//         int *cur_col                 cursor column
+// return: int                          number of rows returned
+//==============================================================================
+static int con_rows (int w, int depth, char *rowp[], int rowlen[],
+                     int *cur_row, int *cur_col)
+{
+ char *p;
+ int skip = con.scroll;
+ int count = 0;
+ int line = con.last;
+ int len;
+ int r;
+ int i;
+
+ *cur_row = -1;
+
+ // collect the rows from the bottom up
+ for (i = 0; (i < con.lines) && (count < depth); i++)
+    {
+     for (r = con_line_rows(line, w) - 1; (r >= 0) && (count < depth); r--)
         {
-         for (x = 0; x < font.width; x++)
-            put_pixel(curs_x + x, curs_y + y, font.fgc);
+         if (skip)
+            {
+             skip--;
+             continue;
+            }
+         len = con.len[line] - r * w;
+         rowp[count] = con.text[line] + r * w;
+         rowlen[count] = (len > w) ? w : len;
+         if ((line == con.last) && (r == con.len[line] / w))
+            {
+             *cur_row = count;
+             *cur_col = len;
+            }
+         count++;
         }
+     line = (line - 1) & (OSD_CON_LINES - 1);
+    }
+
+ // put them in top down order
+ for (i = 0; i < count / 2; i++)
+    {
+     p = rowp[i];
+     rowp[i] = rowp[count - 1 - i];
+     rowp[count - 1 - i] = p;
+     len = rowlen[i];
+     rowlen[i] = rowlen[count - 1 - i];
+     rowlen[count - 1 - i] = len;
+    }
+ if (*cur_row != -1)
+    *cur_row = count - 1 - *cur_row;
+
+ return count;
+}
+
+//==============================================================================
+// Draw the console text.  Only rows that differ from those last drawn are
+// drawn unless a full draw is requested, the cursor cell is then drawn in
+// its current flashing state.
+//
+//   pass: box_t *box                   console main box
+//         int full                     draw all rows if set
+// return: void
+//==============================================================================
+static void con_draw (box_t *box, int full)
+{
+ char *rowp[OSD_CON_ROWS];
+ int rowlen[OSD_CON_ROWS];
+ int cur_row;
+ int cur_col;
+ int rows;
+ int w;
+ int depth;
+ int len;
+ int x;
+ int y;
+ int i;
+
+ int bgc;
+ int fgc;
+ int tbgc;
+ int tfgc;
+
+ w = box->text_width;
+ if (w > OSD_CON_LINE_MAX)
+    w = OSD_CON_LINE_MAX;
+ depth = box->text_depth;
+ if (depth > OSD_CON_ROWS)
+    depth = OSD_CON_ROWS;
+ if ((w < 1) || (depth < 1))
+    {
+     cursor.valid = 0;
+     return;
     }
+
+ set_box_col(box, &bgc, &fgc);
+ set_text_col(box, &tbgc, &tfgc);
+
+ rows = con_rows(w, depth, rowp, rowlen, &cur_row, &cur_col);
+
+ font.data = fontdata;
+ font.depth = OSD_FONT_DEPTH;
+ font.width = OSD_FONT_WIDTH;
+ font.x_f = box->text_posx_f;
+ font.y_f = box->text_posy_f;
+ font.bgc = tbgc;
+ font.fgc = tfgc;
+
+ for (y = 0; y < depth; y++)
+    {
+     len = (y < rows) ? rowlen[y] : 0;
+     if ((! full) && (len == con_shown_len[y]) &&
+        (memcmp(rowp[y], con_shown[y], len) == 0))
+        continue;
+
+     font.x_s = box->text_posx_s;
+     font.y_s = box->text_posy_s + y * OSD_FONT_DEPTH;
+     font.xorig = font.x_s;
+     font.yorig = font.y_s;
+     fill_rect(font.x_s, font.y_s, font.x_s + w * OSD_FONT_WIDTH - 1,
+               font.y_s + OSD_FONT_DEPTH - 1, bgc);
+     if ((cursor.valid) && (cursor.y == font.y_s))
+        cursor.on = 0;
+     for (i = 0; i < len; i++)
+        write_char_to_osd(rowp[y][i]);
+
+     if (len)
+        memcpy(con_shown[y], rowp[y], len);
+     con_shown_len[y] = len;
+    }
+
+ if (cur_row == -1)
+    {
+     if ((cursor.valid) && (cursor.on))
+        fill_rect(cursor.x, cursor.y, cursor.x + OSD_FONT_WIDTH - 1,
+                  cursor.y + OSD_FONT_DEPTH - 1, cursor.bgc);
+     cursor.valid = 0;
+     return;
+    }
+
+ x = box->text_posx_s + cur_col * OSD_FONT_WIDTH;
+ y = box->text_posy_s + cur_row * OSD_FONT_DEPTH;
+
+ // remove the cursor from where it was
+ if ((cursor.valid) && (cursor.on) && ((cursor.x != x) || (cursor.y != y)))
+    fill_rect(cursor.x, cursor.y, cursor.x + OSD_FONT_WIDTH - 1,
+              cursor.y + OSD_FONT_DEPTH - 1, cursor.bgc);
+
+ cursor.valid = 1;
+ cursor.x = x;
+ cursor.y = y;
+ cursor.fgc = tfgc;
+ cursor.bgc = bgc;
+ cursor.on = cursor_phase(box);
+ fill_rect(x, y, x + OSD_FONT_WIDTH - 1, y + OSD_FONT_DEPTH - 1,
+           cursor.on ? cursor.fgc : cursor.bgc);
 }
 
 //==============================================================================
@@ -1232,8 +1782,6 @@ static void write_buffer_to_osd (box_t *box, int bufpos)
      if (++bufpos >= CONSOLE_SIZE)
         bufpos = 0;
     }
-
- update_cursor(box);
 }
 
 //==============================================================================
@@ -1317,6 +1865,16 @@ static int find_buffer_position (box_t *box)
 //==============================================================================
 static void osd_write_char_to_buffer (mbox_t *mbox, int c)
 {
+ // the console only needs its changed rows drawn again
+ if (mbox->main.text == dialogue_console)
+    {
+     con_putchar(&mbox->main, c);
+     if ((emu.display_context == EMU_OSD_CONTEXT) &&
+        (mbox->dialogue) && (! mbox->minimised))
+        crtc.update = 1;
+     return;
+    }
+
  switch (c)
     {
      case '\b' : // destructive backspace
@@ -1352,11 +1910,12 @@ static void osd_write_char_to_buffer (mbox_t *mbox, int c)
 
  // keep the buffer NULL terminated
  mbox->main.text[mbox->main.text_buf_put] = 0;
+ text_gen++;
 
  // if this dialogue is currently displayed then make it get updated
  if ((emu.display_context == EMU_OSD_CONTEXT) &&
      (mbox->dialogue) && (! mbox->minimised))
-    crtc_set_redraw();
+    crtc.update = 1;
 }
 
 //==============================================================================
@@ -1528,16 +2087,10 @@ static void fill_box (box_t *box)
 {
  int bgc;
  int fgc;
- int x;
- int y;
 
  set_box_col(box, &bgc, &fgc);
 
- for (y = box->posy_s; y <= box->posy_f; y++)
-    {
-     for (x = box->posx_s; x <= box->posx_f; x++)
-        put_pixel(x, y, bgc);
-    }
+ fill_rect(box->posx_s, box->posy_s, box->posx_f, box->posy_f, bgc);
 }
 
 //==============================================================================
@@ -1552,25 +2105,18 @@ static void draw_box (box_t *box)
  int fgc;
  int x;
  int y;
+ int n = box->attr & 0x07;
 
  int dash_count = 0;
 
  set_box_col(box, &bgc, &fgc);
 
- for (y = box->posy_s; y <= box->posy_f; y++)
-    {
-     for (x = 0; x < (box->attr & 0x07); x++)
-        put_pixel(box->posx_s + x, y, fgc);
-     for (x = 0; x < (box->attr & 0x07); x++)
-        put_pixel(box->posx_f - x, y, fgc);
-    }
-
- for (x = box->posx_s; x <= box->posx_f; x++)
+ if (n)
     {
-     for (y = 0; y < (box->attr & 0x07); y++)
-        put_pixel(x, box->posy_s + y, fgc);
-     for (y = 0; y < (box->attr & 0x07); y++)
-        put_pixel(x, box->posy_f - y, fgc);
+     fill_rect(box->posx_s, box->posy_s, box->posx_s + n - 1, box->posy_f, fgc);
+     fill_rect(box->posx_f - n + 1, box->posy_s, box->posx_f, box->posy_f, fgc);
+     fill_rect(box->posx_s, box->posy_s, box->posx_f, box->posy_s + n - 1, fgc);
+     fill_rect(box->posx_s, box->posy_f - n + 1, box->posx_f, box->posy_f, fgc);
     }
 
  // draw a dashed text outline if the attribute bit is set
@@ -1633,6 +2179,12 @@ static void text_box (box_t *box, int find_buf_pos)
  box->text_width = ((box->text_posx_f - box->text_posx_s) + 1) / OSD_FONT_WIDTH;
  box->text_depth = ((box->text_posy_f - box->text_posy_s) + 1) / OSD_FONT_DEPTH;
 
+ if (box->text == dialogue_console)
+    {
+     con_draw(box, 1);
+     return;
+    }
+
 // determine how far back up in the buffer to start displaying from
  if (find_buf_pos)
     bufpos = find_buffer_position(box);
@@ -1642,19 +2194,37 @@ static void text_box (box_t *box, int find_buf_pos)
  write_buffer_to_osd(box, bufpos);
 }
 
+//==============================================================================
+// Check if a box is the same as when it was last drawn on the canvas.
+//
+//   pass: box_t *box                   dialogue box
+//         box_t *last                  box as last drawn
+// return: int                          1 if unchanged, else 0
+//==============================================================================
+static int box_unchanged (box_t *box, box_t *last)
+{
+ return (! redraw_all) && (memcmp(box, last, sizeof(box_t)) == 0);
+}
+
 //==============================================================================
 // Create the main dialogue box.
 //
+// If the box and its text are unchanged only the cursor is updated,
+// otherwise the box is drawn and all the other boxes on it are drawn again.
+//
 //   pass: void
 // return: void
 //==============================================================================
 static void create_dialogue_box (void)
 {
- fill_box(&mbox->main);
-
  // save processor time if dialogue is minimised
  if (mbox->minimised)
-    return;
+    {
+     if (! box_unchanged(&mbox->main, &drawn.main))
+        fill_box(&mbox->main);
+     memcpy(&drawn.main, &mbox->main, sizeof(box_t));
+     return;
+    }
 
  mbox->main.bcol = osdsch->dialogue_main_bcol;
  mbox->main.fcol = osdsch->dialogue_main_fcol;
@@ -1679,15 +2249,10 @@ static void create_dialogue_box (void)
  mbox->main.text_bcol = osdsch->dialogue_text_bcol;
  mbox->main.text_fcol = osdsch->dialogue_text_fcol;
 
- if (mbox->icon)
-    put_xpm(mbox->icon, mbox->main.posx_s + ((mbox->main.attr & 0x07) + 4),
-    mbox->main.posy_s + ((mbox->main.attr & 0x07) + 26));
-
  if (! (mbox->attr & MBOX_ATTR_MAXIMISED))
     {
      last_posx_s = mbox->main.posx_f - ((mbox->main.attr & 0x07) + 26);
      last_posx_f = mbox->main.posx_f - ((mbox->main.attr & 0x07) + 4);
-     draw_box(&mbox->main);
     }
  else
     {
@@ -1695,7 +2260,30 @@ static void create_dialogue_box (void)
      last_posx_f = mbox->main.posx_f - ((mbox->main.attr & 0x07) + 1);
     }
 
+ if (box_unchanged(&mbox->main, &drawn.main) && (text_gen == drawn_text_gen))
+    {
+     if (mbox->main.text == dialogue_console)
+        con_draw(&mbox->main, 0);
+     return;
+    }
+
+ // everything else is drawn over the main box
+ redraw_all = 1;
+ cursor.valid = 0;
+
+ fill_box(&mbox->main);
+
+ if (mbox->icon)
+    put_xpm(mbox->icon, mbox->main.posx_s + ((mbox->main.attr & 0x07) + 4),
+    mbox->main.posy_s + ((mbox->main.attr & 0x07) + 26));
+
+ if (! (mbox->attr & MBOX_ATTR_MAXIMISED))
+    draw_box(&mbox->main);
+
  text_box(&mbox->main, mbox->components & BOX_COMP_MAX);
+
+ memcpy(&drawn.main, &mbox->main, sizeof(box_t));
+ drawn_text_gen = text_gen;
 }
 
 //==============================================================================
@@ -1737,9 +2325,13 @@ static void create_close_box (void)
      close_xpm[1] = colour_xpm_ll;
     }
 
+ if (box_unchanged(&mbox->close, &drawn.close))
+    return;
+
  fill_box(&mbox->close);
  draw_box(&mbox->close);
  put_xpm(close_xpm, mbox->close.posx_s + 1, mbox->close.posy_s + 1);
+ memcpy(&drawn.close, &mbox->close, sizeof(box_t));
 }
 
 //==============================================================================
@@ -1787,8 +2379,12 @@ static void create_maximising_box (void)
      maximise_b_xpm[1] = colour_xpm_ll;
     }
 
+ if (box_unchanged(&mbox->max, &drawn.max))
+    return;
+
  fill_box(&mbox->max);
  draw_box(&mbox->max);
+ memcpy(&drawn.max, &mbox->max, sizeof(box_t));
 
  if (mbox->attr & MBOX_ATTR_MAXIMISED)
     put_xpm(maximise_b_xpm, mbox->max.posx_s + 1, mbox->max.posy_s + 1);
@@ -1838,9 +2434,13 @@ static void create_minimise_box (void)
      minimise_xpm[1] = colour_xpm_ll;
     }
 
+ if (box_unchanged(&mbox->min, &drawn.min))
+    return;
+
  fill_box(&mbox->min);
  draw_box(&mbox->min);
  put_xpm(minimise_xpm, mbox->min.posx_s + 1, mbox->min.posy_s + 1);
+ memcpy(&drawn.min, &mbox->min, sizeof(box_t));
 }
 
 //==============================================================================
@@ -1903,9 +2503,13 @@ static void create_title_box (void)
  
  mbox->title.text_posy_f = mbox->title.posy_f;
 
+ if (box_unchanged(&mbox->title, &drawn.title))
+    return;
+
  fill_box(&mbox->title);
  draw_box(&mbox->title);
  text_box(&mbox->title, 0);
+ memcpy(&drawn.title, &mbox->title, sizeof(box_t));
 }
 
 //==============================================================================
@@ -1971,9 +2575,13 @@ static void create_button_box (int btn)
      mbox->btn[btn].text_fcol = osdsch->button_text_fcol_ll;
     }   
 
+ if (box_unchanged(&mbox->btn[btn], &drawn.btn[btn]))
+    return;
+
  fill_box(&mbox->btn[btn]);
  draw_box(&mbox->btn[btn]);
  text_box(&mbox->btn[btn], 0);
+ memcpy(&drawn.btn[btn], &mbox->btn[btn], sizeof(box_t));
 }
 
 //==============================================================================
@@ -1999,15 +2607,28 @@ static void set_minimised_values (void)
 //==============================================================================
 // Draw the current dialogue.
 //
+// The boxes that have changed since the dialogue was last drawn are drawn on
+// the canvas, then the dialogue is blitted from the canvas to the display
+// surface.  The display under the dialogue may have been drawn over since
+// the last time so the blit is always done.
+//
 //   pass: void
 // return: void
 //==============================================================================
 static void draw_dialogue (void)
 {
+ SDL_Rect srcrect;
+ SDL_Rect dstrect;
+ int x1, y1, x2, y2;
  int i;
+
  spf = screen->format;
 
- SDL_LockSurface(screen);
+ redraw_all = osd_canvas_check() || (mbox != drawn_mbox) ||
+              (mbox->attr != drawn.attr) ||
+              (mbox->minimised != drawn.minimised) ||
+              (mbox->icon != drawn.icon) || (emu.osd_focus != drawn_focus);
+ target = canvas ? canvas : screen;
 
  create_dialogue_box();
 
@@ -2022,7 +2643,37 @@ static void draw_dialogue (void)
        create_button_box(i);
     }
 
- SDL_UnlockSurface(screen);
+ drawn_mbox = mbox;
+ drawn.attr = mbox->attr;
+ drawn.minimised = mbox->minimised;
+ drawn.icon = mbox->icon;
+ drawn_focus = emu.osd_focus;
+
+ x1 = mbox->main.posx_s;
+ y1 = mbox->main.posy_s * video.yscale;
+ x2 = mbox->main.posx_f + 1;
+ y2 = (mbox->main.posy_f + 1) * video.yscale;
+ if (x1 < 0)
+    x1 = 0;
+ if (y1 < 0)
+    y1 = 0;
+ if (x2 > screen->w)
+    x2 = screen->w;
+ if (y2 > screen->h)
+    y2 = screen->h;
+ if ((x1 >= x2) || (y1 >= y2))
+    return;
+
+ srcrect.x = x1;
+ srcrect.y = y1;
+ srcrect.w = x2 - x1;
+ srcrect.h = y2 - y1;
+ if (canvas)
+    {
+     dstrect = srcrect;
+     SDL_BlitSurface(canvas, &srcrect, screen, &dstrect);
+    }
+ video_update_region(srcrect);
 }
 
 //==============================================================================
@@ -2084,6 +2735,9 @@ static void animate_minimising (void)
         animating--;
        }
 
+ // the outline is drawn straight onto the display surface
+ target = screen;
+
  if (animating)
     draw_box(&animated_mbox.main);
  else
@@ -2302,9 +2956,9 @@ void update_dialogue_highlights (int mouse_x, int mouse_y)
         mbox->btn[i].attr &= ~BOX_ATTR_HIGH;
     }
 
- // need to force a redraw to show attribute and drag changes otherwise may
- // be slow to display if CRTC not doing anything
- crtc_set_redraw();
+ // need to force an update to show attribute changes otherwise may be slow
+ // to display if CRTC not doing anything
+ crtc.update = 1;
 }
 
 //==============================================================================
@@ -2383,6 +3037,13 @@ void osd_keydown_event (void)
      int c = emu.event.key.keysym.unicode & 0x7F;
      osd.key = c;
 
+     // typing returns the view to the last line
+     if ((c) && (con.scroll))
+        {
+         con.scroll = 0;
+         crtc.update = 1;
+        }
+
      // if the 'help option' is currently active
      if ((help.state) && (help.state != -1))
         {
@@ -2425,6 +3086,15 @@ void osd_keydown_event (void)
         draw_dialogue();
         video_render();
         break;
+     case SDLK_PAGEUP :
+     case SDLK_PAGEDOWN :
+        if (mbox->main.text != dialogue_console)
+           break;
+        if (key == SDLK_PAGEUP)
+           con_scroll(&mbox->main, mbox->main.text_depth - 1);
+        else
+           con_scroll(&mbox->main, -(mbox->main.text_depth - 1));
+        break;
      default :
         break;
     }
@@ -2757,9 +3427,13 @@ void osd_mousemotion_event (void)
         }
     }
 
- // need to force a redraw to show attribute and drag changes otherwise may
- // be slow to display if CRTC not doing anything
- crtc_set_redraw();
+ // need to force an update to show attribute and drag changes otherwise may
+ // be slow to display if CRTC not doing anything.  Dragging uncovers the
+ // display under the dialogue so that needs a redraw.
+ if (drag_window)
+    crtc_set_redraw();
+ else
+    crtc.update = 1;
 
  mouse_x_last = x;
  mouse_y_last = y;
@@ -2978,6 +3652,9 @@ static void osd_dialogue (int dialogue)
  int devices;
  char devices_name[20];
 
+ // the OSD draws directly into the display surface
+ video_thread_sync();
+
  osd.dialogue = dialogue;
  mbox = &dialogues[dialogue];
 
@@ -3053,6 +3730,7 @@ static void osd_dialogue (int dialogue)
     osd_set_dialogue_pos(OSD_POS_MOUSEORCENTER);
 
  // draw the dialogue box
+ drawn_mbox = NULL;
  draw_dialogue();
  crtc.update = 1;
 
@@ -3216,7 +3894,7 @@ void osd_redraw (void)
 // has completed from the video_update() function.
 //
 // Sets the crtc.update flag if the OSD animated minimising function needs
-// to update the display.
+// to update the display or the console cursor needs to be flashed.
 //
 //   pass: void
 // return: void
@@ -3236,9 +3914,11 @@ void osd_update (void)
      crtc.update = 1;
     }
  else
-    // need to update if DIALOGUE_CONSOLE is in context for cursor flashing
+    // need to update if DIALOGUE_CONSOLE is in context and the cursor has
+    // changed state
     if ((emu.display_context == EMU_OSD_CONTEXT) &&
-       (mbox->dialogue == DIALOGUE_CONSOLE) && (! mbox->minimised))
+       (mbox->dialogue == DIALOGUE_CONSOLE) && (! mbox->minimised) &&
+       (cursor.valid) && (cursor_phase(&mbox->main) != cursor.on))
        crtc.update = 1;
 }
 
@@ -3262,8 +3942,7 @@ static void osd_configure_scheme (void)
  dialogues[DIALOGUE_CONSOLE].main.cursor_rate = osdsch->console_cursor_rate;
 
  // set the widget's xpm icon colours 
- sprintf(colour_xpm_hl, "  c #%6X", osdsch->widget_xpm_hl);
- sprintf(colour_xpm_ll, "  c #%6X", osdsch->widget_xpm_ll);
+ osd_set_xpm_colours();
 }
 
 //==============================================================================
@@ -3540,8 +4219,7 @@ int osd_set_scheme (char *p)
      osdsch = &osdsch_schemes[scheme];
 
      // set the widget's xpm icon colours 
-     sprintf(colour_xpm_hl, "  c #%6X", osdsch->widget_xpm_hl);
-     sprintf(colour_xpm_ll, "  c #%6X", osdsch->widget_xpm_ll);
+     osd_set_xpm_colours();
 
      return 0;
     }
@@ -3675,8 +4353,7 @@ int osd_set_colour (char *p, int option)
  if (option != OPT_OSD_SET_WID_ICON)
     return 0;
 
- sprintf(colour_xpm_hl, "  c #%6X", osdsch->widget_xpm_hl);
- sprintf(colour_xpm_ll, "  c #%6X", osdsch->widget_xpm_ll);
+ osd_set_xpm_colours();
 
  return 0;
 }
@@ -102,6 +102,17 @@
 #define SHARED_SIZE         1000
 #define CONSOLE_SIZE        10000
 
+#define OSD_FONT_GLYPHS     128
+#define OSD_GLYPH_CACHES    8
+#define OSD_XPM_CACHES      16
+
+// console text lines kept for scrolling back (must be a power of 2), the
+// longest line before it is forced onto a new line and the most text rows
+// that are displayed
+#define OSD_CON_LINES       4096
+#define OSD_CON_LINE_MAX    256
+#define OSD_CON_ROWS        128
+
 int osd_init (void);
 int osd_deinit (void);
 int osd_reset (void);
@@ -193,6 +204,39 @@ typedef struct font_t
     int fgc;
    }font_t;
 
+typedef struct osd_glyphs_t
+   {
+    SDL_Surface *s;      // font drawn in the display format
+    int fgc;             // mapped foreground colour
+    int bgc;             // mapped background colour
+   }osd_glyphs_t;
+
+typedef struct osd_xpm_t
+   {
+    char **xpm;          // XPM image
+    char *colour;        // first colour line when drawn
+    SDL_Surface *s;      // image with alpha for transparent pixels
+   }osd_xpm_t;
+
+typedef struct osd_cursor_t
+   {
+    int valid;           // cursor cell is inside the console text area
+    int on;              // cursor is drawn
+    int x;
+    int y;
+    int fgc;             // cursor colour
+    int bgc;             // background colour when not drawn
+   }osd_cursor_t;
+
+typedef struct osd_con_t
+   {
+    char text[OSD_CON_LINES][OSD_CON_LINE_MAX];
+    int len[OSD_CON_LINES];
+    int last;            // line being written to
+    int lines;           // number of lines in use
+    int scroll;          // rows scrolled back from the last row
+   }osd_con_t;
+
 typedef struct x11_rgb_col_t
    {
     char *colour;
@@ -47,6 +47,17 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - PIO interrupt sources are now split into those that must be sampled
+//   (serial, mouse, VSYNC, RTC and port A peripherals with a poll function)
+//   and those that signal an edge with the new pio_notify() function
+//   (port A strobes and the 256TC/Teleterm keyboard).  pio_polling() only
+//   samples the ports when an interrupt from a sampled source is possible
+//   or a notification is pending, otherwise it returns immediately.  A
+//   notified edge that can't interrupt yet is kept (port A notification or
+//   port B change bits) until the interrupt has been raised, no lock is
+//   taken on the idle path.
+//
 // v5.0.0 - 13 July 2010, K Duckmanton
 // - Removed all references to the 'sound' global variable and replaced them
 //   with references to the 'audio' global instead.
@@ -194,6 +205,7 @@ pio_t pio_b;
 static z80_device_interrupt_t pio_int_scratch;
 
 static int polling;
+static volatile int pio_events;
 
 extern int coms1;
 
@@ -420,17 +432,92 @@ int pio_porta_connect(parint_ops_t *device)
  return 0;                      /* success */
 }
 
+//==============================================================================
+// PIO - test if an interrupt source must be sampled.
+//
+// Sources that are derived from the Z80 tstate count or host time have to
+// be sampled to detect an edge, this is only needed if the port has
+// interrupts enabled and the source bit is not masked.
+//
+// A port B edge that could not raise an interrupt when it was evaluated
+// (interrupts disabled or a higher priority device holding IEI) is kept in
+// the change bits and the port continues to be sampled until pio_update()
+// has raised the interrupt for it.  Port A keeps its notification instead,
+// see pio_polling().
+//
+//   pass: void
+// return: int                          port events to be sampled
+//==============================================================================
+static int pio_sampled_sources (void)
+{
+ int events = 0;
+ int bits;
+
+ if (pio_a.ienableff && pio_a_peripheral && pio_a_peripheral->poll)
+    events |= PIO_A_INTRPEND;
+
+ if (pio_b.ienableff)
+    {
+     bits = PIO_B_RS232_RX | PIO_B_RS232_DTR;
+     if ((modelx.piob7 == MODPB7_VS) || (modelx.piob7 == MODPB7_RTC))
+        bits |= PIO_B_CLOCK;
+     if (bits & pio_b.direction & ~pio_b.maskword)
+        events |= PIO_B_INTRPEND;
+
+     // changes at the active level that have not been serviced yet
+     if (pio_b.change & ~(pio_b.last ^ pio_b.hilo) & ~pio_b.maskword)
+        events |= PIO_B_INTRPEND;
+    }
+
+ return events;
+}
+
+//==============================================================================
+// PIO - notify an interrupt event.
+//
+// Called by a source when an edge occurs that may generate an interrupt. The
+// port is then evaluated on the next PIO poll which is requested to occur
+// after the current Z80 instruction.  May be called from any thread.
+//
+//   pass: int event                    PIO_A_INTRPEND and/or PIO_B_INTRPEND
+// return: void
+//==============================================================================
+void pio_notify (int event)
+{
+ __sync_fetch_and_or(&pio_events, event);
+ z80api_poll_now();
+}
+
 //==============================================================================
 // PIO - poll for interrupt events.
 //
+// A port is only read if one of its sources must be sampled or a source has
+// notified an event.  A port A notification is left set until pio_update()
+// gets as far as raising the interrupt so it is retried if interrupts can't
+// be taken yet, it is not acted on while port A interrupts are disabled.
+//
 //   pass: void
 // return: void
 //==============================================================================
 void pio_polling (void)
 {
+ int events;
+
+ events = pio_sampled_sources();
+ if (pio_events)
+    {
+     events |= __sync_fetch_and_and(&pio_events, PIO_A_INTRPEND);
+     if (! pio_a.ienableff)
+        events &= ~PIO_A_INTRPEND;
+    }
+ if (! events)
+    return;
+
  polling = 1;
- pio_r(0x00, NULL);
- pio_r(0x02, NULL);
+ if (events & PIO_A_INTRPEND)
+    pio_r(0x00, NULL);
+ if (events & PIO_B_INTRPEND)
+    pio_r(0x02, NULL);
  polling = 0;
 }
 
@@ -635,6 +722,10 @@ static void pio_update (void)
 
  if (pio_a.ienableff)
     {
+     // the notification is taken before the pending flag is tested so a
+     // strobe from another thread after this is seen on the next poll
+     if (pio_events & PIO_A_INTRPEND)
+        __sync_fetch_and_and(&pio_events, ~PIO_A_INTRPEND);
      if (pio_a_peripheral && pio_a_peripheral->poll)
         (*pio_a_peripheral->poll)();
      SDL_LockMutex(pio_a.pending_mutex);
@@ -782,6 +873,7 @@ void pio_porta_strobe(void)
  SDL_LockMutex(pio_a.pending_mutex);
  pio_a.pending = 1;
  SDL_UnlockMutex(pio_a.pending_mutex);
+ pio_notify(PIO_A_INTRPEND);
 }
 
 //==============================================================================
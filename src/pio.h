@@ -12,6 +12,7 @@ int pio_init (void);
 int pio_deinit (void);
 int pio_reset (void);
 void pio_polling (void);
+void pio_notify (int event);
 void pio_porta_strobe(void);
 void pio_configure (int cpuclock);
 void pio_regdump (void);
@@ -31,6 +31,10 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - rtc_r() now calls rtc_poll() before a register is read as the PIO no
+//   longer polls the RTC unless it's being used as an interrupt source.
+//
 // v4.7.0 - 29 June 2010, uBee
 // - Changes made to fread() function to use the result as some compilers
 //   report warning: declared with attribute warn_unused_result.
@@ -526,6 +530,7 @@ uint16_t rtc_r (uint16_t port, struct z80_port_read *port_s)
                log_port_1("rtc_r", "data", port, 0);
             return 0;
          case 0x07 :
+            rtc_poll();         // bring the time and flags up to date
             data = rtcx.ram[addr];
             if (addr < reg_a)
                {
@@ -645,8 +650,8 @@ void rtc_w (uint16_t port, uint8_t data, struct z80_port_write *port_s)
 // Read the host system time and check for any RTC flags that may need setting
 // and any interrupts to be generated.
 //
-// This function should only be called from the pio_poll() function as only
-// the current accumulated Z80 cycles are used here.
+// This is called when PIO port B is sampled and before a register is read,
+// only the current accumulated Z80 cycles are used here.
 //
 // The accuracy of the periodic flag is very dependent on the polling rate
 // and emulated CPU clock rate.
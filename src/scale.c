@@ -0,0 +1,406 @@
+//******************************************************************************
+//*                                  uBee512                                   *
+//*       An emulator for the Microbee Z80 ROM, FDD and HDD based models       *
+//*                                                                            *
+//*                                scale module                                *
+//*                                                                            *
+//*                       Copyright (C) 2007-2016 uBee                         *
+//******************************************************************************
+//
+// Scales blocks of 8, 16 or 32 bit pixels up by a whole number factor for
+// the SDL software scaler (--video-scale).
+//
+// Each source row is scaled horizontally once and the result copied for the
+// remaining output rows.  The last output row of each source row may be
+// darkened to give a scan line effect.  SSE2 and AVX2 versions of the 2x and
+// 4x row scaling are used when the host CPU supports them, the choice is
+// made at run time by scale_init().  The 3x factor and other hosts use the
+// portable versions.
+//
+//==============================================================================
+/*
+ *  uBee512 - An emulator for the Microbee Z80 ROM, FDD and HDD based models.
+ *  Copyright (C) 2007-2016 uBee
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+//==============================================================================
+// ChangeLog (most recent entries are at top)
+//==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Created a new file to implement the software scaler.
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "scale.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SCALE_X86
+#include <immintrin.h>
+#endif
+
+//==============================================================================
+// structures and variables
+//==============================================================================
+typedef void (*scale_darken_fn)(uint8_t *dst, int bytes, uint32_t dark);
+
+static void scale_row_8bpp (uint8_t *dst, const uint8_t *src, int n,
+                            int factor);
+static void scale_row_16bpp (uint8_t *dst, const uint8_t *src, int n,
+                             int factor);
+static void scale_row_32bpp (uint8_t *dst, const uint8_t *src, int n,
+                             int factor);
+static void scale_darken (uint8_t *dst, int bytes, uint32_t dark);
+
+scale_row_fn scale_row_p[5] =
+{
+ NULL,
+ scale_row_8bpp,
+ scale_row_16bpp,
+ NULL,
+ scale_row_32bpp
+};
+
+static scale_darken_fn scale_darken_p = scale_darken;
+
+static const char *scale_kernel = "C";
+
+//==============================================================================
+// Portable versions.
+//
+//   pass: see scale_row_fn in scale.h
+// return: void
+//==============================================================================
+static void scale_row_8bpp (uint8_t *dst, const uint8_t *src, int n,
+                            int factor)
+{
+ while (n--)
+    {
+     memset(dst, *src++, factor);
+     dst += factor;
+    }
+}
+
+static void scale_row_16bpp (uint8_t *dst, const uint8_t *src, int n,
+                             int factor)
+{
+ uint16_t *d = (uint16_t *)dst;
+ uint16_t p;
+ int i;
+
+ while (n--)
+    {
+     memcpy(&p, src, 2);
+     src += 2;
+     for (i = 0; i < factor; i++)
+        *d++ = p;
+    }
+}
+
+static void scale_row_32bpp (uint8_t *dst, const uint8_t *src, int n,
+                             int factor)
+{
+ uint32_t *d = (uint32_t *)dst;
+ uint32_t p;
+ int i;
+
+ while (n--)
+    {
+     memcpy(&p, src, 4);
+     src += 4;
+     for (i = 0; i < factor; i++)
+        *d++ = p;
+    }
+}
+
+//==============================================================================
+// Darken a row of pixels to half brightness.  The row is taken 32 bits at a
+// time, each bit is moved down one place and any bit that moved into
+// another colour component is removed by the mask.
+//
+//   pass: uint8_t *dst                 first pixel
+//         int bytes                    number of bytes in the row
+//         uint32_t dark                mask for the shifted pixel pairs
+// return: void
+//==============================================================================
+static void scale_darken (uint8_t *dst, int bytes, uint32_t dark)
+{
+ uint32_t p;
+ uint16_t p16;
+
+ for (; bytes >= 4; bytes -= 4, dst += 4)
+    {
+     memcpy(&p, dst, 4);
+     p = (p >> 1) & dark;
+     memcpy(dst, &p, 4);
+    }
+
+ // a 16 bit row may end on half a word
+ if (bytes >= 2)
+    {
+     memcpy(&p16, dst, 2);
+     p16 = (p16 >> 1) & dark;
+     memcpy(dst, &p16, 2);
+    }
+}
+
+#ifdef SCALE_X86
+//==============================================================================
+// SSE2 versions.
+//
+// The pixels are doubled by interleaving a register with itself, twice for
+// the 4x factor.  The pixels left over at the end of a row are done by the
+// portable versions.
+//
+//   pass: see scale_row_fn in scale.h
+// return: void
+//==============================================================================
+__attribute__((target("sse2")))
+static void scale_row_8bpp_sse2 (uint8_t *dst, const uint8_t *src, int n,
+                                 int factor)
+{
+ __m128i v;
+ __m128i lo;
+ __m128i hi;
+
+ if (factor == 3)
+    {
+     scale_row_8bpp(dst, src, n, factor);
+     return;
+    }
+
+ for (; n >= 16; n -= 16, src += 16)
+    {
+     v = _mm_loadu_si128((const __m128i *)src);
+     lo = _mm_unpacklo_epi8(v, v);
+     hi = _mm_unpackhi_epi8(v, v);
+     if (factor == 2)
+        {
+         _mm_storeu_si128((__m128i *)dst, lo);
+         _mm_storeu_si128((__m128i *)(dst + 16), hi);
+         dst += 32;
+        }
+     else
+        {
+         _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(lo, lo));
+         _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(lo, lo));
+         _mm_storeu_si128((__m128i *)(dst + 32), _mm_unpacklo_epi16(hi, hi));
+         _mm_storeu_si128((__m128i *)(dst + 48), _mm_unpackhi_epi16(hi, hi));
+         dst += 64;
+        }
+    }
+
+ scale_row_8bpp(dst, src, n, factor);
+}
+
+__attribute__((target("sse2")))
+static void scale_row_16bpp_sse2 (uint8_t *dst, const uint8_t *src, int n,
+                                  int factor)
+{
+ __m128i v;
+ __m128i lo;
+ __m128i hi;
+
+ if (factor == 3)
+    {
+     scale_row_16bpp(dst, src, n, factor);
+     return;
+    }
+
+ for (; n >= 8; n -= 8, src += 16)
+    {
+     v = _mm_loadu_si128((const __m128i *)src);
+     lo = _mm_unpacklo_epi16(v, v);
+     hi = _mm_unpackhi_epi16(v, v);
+     if (factor == 2)
+        {
+         _mm_storeu_si128((__m128i *)dst, lo);
+         _mm_storeu_si128((__m128i *)(dst + 16), hi);
+         dst += 32;
+        }
+     else
+        {
+         _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi32(lo, lo));
+         _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi32(lo, lo));
+         _mm_storeu_si128((__m128i *)(dst + 32), _mm_unpacklo_epi32(hi, hi));
+         _mm_storeu_si128((__m128i *)(dst + 48), _mm_unpackhi_epi32(hi, hi));
+         dst += 64;
+        }
+    }
+
+ scale_row_16bpp(dst, src, n, factor);
+}
+
+__attribute__((target("sse2")))
+static void scale_row_32bpp_sse2 (uint8_t *dst, const uint8_t *src, int n,
+                                  int factor)
+{
+ __m128i v;
+
+ if (factor == 3)
+    {
+     scale_row_32bpp(dst, src, n, factor);
+     return;
+    }
+
+ for (; n >= 4; n -= 4, src += 16)
+    {
+     v = _mm_loadu_si128((const __m128i *)src);
+     if (factor == 2)
+        {
+         _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi32(v, v));
+         _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi32(v, v));
+         dst += 32;
+        }
+     else
+        {
+         _mm_storeu_si128((__m128i *)dst, _mm_shuffle_epi32(v, 0x00));
+         _mm_storeu_si128((__m128i *)(dst + 16), _mm_shuffle_epi32(v, 0x55));
+         _mm_storeu_si128((__m128i *)(dst + 32), _mm_shuffle_epi32(v, 0xaa));
+         _mm_storeu_si128((__m128i *)(dst + 48), _mm_shuffle_epi32(v, 0xff));
+         dst += 64;
+        }
+    }
+
+ scale_row_32bpp(dst, src, n, factor);
+}
+
+__attribute__((target("sse2")))
+static void scale_darken_sse2 (uint8_t *dst, int bytes, uint32_t dark)
+{
+ const __m128i m = _mm_set1_epi32(dark);
+ __m128i v;
+
+ for (; bytes >= 16; bytes -= 16, dst += 16)
+    {
+     v = _mm_loadu_si128((const __m128i *)dst);
+     v = _mm_and_si128(_mm_srli_epi32(v, 1), m);
+     _mm_storeu_si128((__m128i *)dst, v);
+    }
+
+ scale_darken(dst, bytes, dark);
+}
+
+//==============================================================================
+// AVX2 version.
+//
+// Only the 32 bpp row is done with 256 bit registers, each output register
+// is a permutation of the 8 source pixels.
+//
+//   pass: see scale_row_fn in scale.h
+// return: void
+//==============================================================================
+__attribute__((target("avx2")))
+static void scale_row_32bpp_avx2 (uint8_t *dst, const uint8_t *src, int n,
+                                  int factor)
+{
+ __m256i v;
+ int i;
+
+ if (factor == 3)
+    {
+     scale_row_32bpp(dst, src, n, factor);
+     return;
+    }
+
+ for (; n >= 8; n -= 8, src += 32)
+    {
+     v = _mm256_loadu_si256((const __m256i *)src);
+     for (i = 0; i < 8; i += 8 / factor, dst += 32)
+        _mm256_storeu_si256((__m256i *)dst,
+           _mm256_permutevar8x32_epi32(v, (factor == 2) ?
+              _mm256_setr_epi32(i, i, i + 1, i + 1, i + 2, i + 2, i + 3, i + 3) :
+              _mm256_setr_epi32(i, i, i, i, i + 1, i + 1, i + 1, i + 1)));
+    }
+
+ scale_row_32bpp(dst, src, n, factor);
+}
+#endif
+
+//==============================================================================
+// Scale initialise.
+//
+// Selects the fastest versions the host CPU supports.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void scale_init (void)
+{
+#ifdef SCALE_X86
+ __builtin_cpu_init();
+ if (__builtin_cpu_supports("sse2"))
+    {
+     scale_row_p[1] = scale_row_8bpp_sse2;
+     scale_row_p[2] = scale_row_16bpp_sse2;
+     scale_row_p[4] = scale_row_32bpp_sse2;
+     scale_darken_p = scale_darken_sse2;
+     scale_kernel = "SSE2";
+    }
+ if (__builtin_cpu_supports("avx2"))
+    {
+     scale_row_p[4] = scale_row_32bpp_avx2;
+     scale_kernel = "AVX2";
+    }
+#endif
+}
+
+//==============================================================================
+// Name of the instruction set used by the selected versions.
+//
+//   pass: void
+// return: const char *
+//==============================================================================
+const char *scale_name (void)
+{
+ return scale_kernel;
+}
+
+//==============================================================================
+// Scale a block of pixels.
+//
+//   pass: uint8_t *dst                 first destination pixel
+//         int dst_pitch                bytes between destination rows
+//         const uint8_t *src           first source pixel
+//         int src_pitch                bytes between source rows
+//         int w                        width of the block in source pixels
+//         int h                        height of the block in source rows
+//         int bpp                      bytes per pixel (1, 2 or 4)
+//         int factor                   scale factor (2 to SCALE_MAX)
+//         uint32_t dark                scan line mask, 0 for no scan lines
+// return: void
+//==============================================================================
+void scale_block (uint8_t *dst, int dst_pitch, const uint8_t *src,
+                  int src_pitch, int w, int h, int bpp, int factor,
+                  uint32_t dark)
+{
+ int bytes = w * factor * bpp;
+ int i;
+
+ while (h--)
+    {
+     scale_row_p[bpp](dst, src, w, factor);
+     for (i = 1; i < factor; i++)
+        memcpy(dst + i * dst_pitch, dst, bytes);
+     if (dark)
+        scale_darken_p(dst + (factor - 1) * dst_pitch, bytes, dark);
+     src += src_pitch;
+     dst += factor * dst_pitch;
+    }
+}
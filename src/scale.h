@@ -0,0 +1,29 @@
+/* SCALE Header */
+
+#ifndef HEADER_SCALE_H
+#define HEADER_SCALE_H
+
+#include <stdint.h>
+
+// largest software scale factor
+#define SCALE_MAX 4
+
+// Scale a row of pixels horizontally.
+//
+//   dst                first destination pixel
+//   src                first source pixel
+//   n                  number of source pixels
+//   factor             number of times each pixel is written (2-4)
+typedef void (*scale_row_fn)(uint8_t *dst, const uint8_t *src, int n,
+                             int factor);
+
+void scale_init (void);
+const char *scale_name (void);
+void scale_block (uint8_t *dst, int dst_pitch, const uint8_t *src,
+                  int src_pitch, int w, int h, int bpp, int factor,
+                  uint32_t dark);
+
+// indexed by the number of bytes per pixel, NULL if not supported
+extern scale_row_fn scale_row_p[5];
+
+#endif     /* HEADER_SCALE_H */
@@ -0,0 +1,471 @@
+//******************************************************************************
+//*                                  uBee512                                   *
+//*       An emulator for the Microbee Z80 ROM, FDD and HDD based models       *
+//*                                                                            *
+//*                           text terminal module                             *
+//*                                                                            *
+//*                       Copyright (C) 2007-2016 uBee                         *
+//******************************************************************************
+//
+// Draws the CRTC text screen on an ANSI terminal and takes keyboard input
+// from stdin so the emulator can be used over a serial line or SSH session.
+//
+// Each frame the displayed screen RAM locations are decoded to characters
+// with vdu_text_char() and compared with what the terminal is showing, only
+// the changed cells are sent using cursor addressing escape sequences.  The
+// terminal cursor is left at the CRTC cursor position.
+//
+// Keys read from stdin are turned into SDL key down and key up events with
+// any SHIFT or CTRL key needed for a PC keyboard so the emulated keyboard
+// sees the same keys it would from the host keyboard.  Each key is held
+// for a few frames.  CTRL+] followed by 'q' exits the emulator.
+//
+//==============================================================================
+/*
+ *  uBee512 - An emulator for the Microbee Z80 ROM, FDD and HDD based models.
+ *  Copyright (C) 2007-2016 uBee
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+//==============================================================================
+// ChangeLog (most recent entries are at top)
+//==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Screen locations are decoded with vdu_text_char().
+// - Created a new file to implement the text terminal frontend.
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <SDL.h>
+
+#include "ubee512.h"
+#include "term.h"
+#include "console.h"
+#include "crtc.h"
+#include "vdu.h"
+
+//==============================================================================
+// structures and variables
+//==============================================================================
+term_t term;
+
+static uint8_t term_shown[TERM_COLS_MAX * TERM_ROWS_MAX];
+static int term_cols;
+static int term_rows;
+static int term_cur_row;
+static int term_cur_col;
+
+static char term_out[8192];
+static int term_out_len;
+
+static int key_queue[TERM_KEYS];
+static unsigned int key_head;
+static unsigned int key_tail;
+static int key_frames;
+static SDLKey key_sym;
+static SDLKey key_mod;
+static int key_esc;
+static int key_prefix;
+
+static const char shifted_keys[] = "!@#$%^&*()_+{}|:\"<>?~";
+static const char lower_keys[]   = "1234567890-=[]\\;',./`";
+
+extern emu_t emu;
+
+//==============================================================================
+// Terminal initialise.
+//
+// Nothing is done unless the --term option is enabled.  Console output to
+// stdout is turned off while the terminal is drawn.
+//
+//   pass: void
+// return: int                          0 if success, -1 if error
+//==============================================================================
+int term_init (void)
+{
+ key_head = 0;
+ key_tail = 0;
+ key_frames = 0;
+ key_esc = 0;
+ key_prefix = 0;
+
+ if (! term.enable)
+    return 0;
+
+ term.raw = (console_raw_mode(1) == 0);
+ if (! term.raw)
+    xprintf("term_init: stdin is not a terminal, no keys will be read\n");
+
+ term.streams = console_get_devices();
+ console_set_devices(term.streams & ~CONSOLE_STDOUT);
+
+ // alternate screen, clear it and force every cell to be sent
+ fputs("\033[?1049h\033[2J", stdout);
+ fflush(stdout);
+ term_cols = 0;
+ term_rows = 0;
+ term.active = 1;
+
+ return 0;
+}
+
+//==============================================================================
+// Terminal de-initialise.
+//
+//   pass: void
+// return: int                          0
+//==============================================================================
+int term_deinit (void)
+{
+ if (! term.active)
+    return 0;
+
+ fputs("\033[0m\033[?25h\033[?1049l", stdout);
+ fflush(stdout);
+
+ if (term.raw)
+    console_raw_mode(0);
+ term.raw = 0;
+
+ console_set_devices(term.streams);
+ term.active = 0;
+
+ return 0;
+}
+
+//==============================================================================
+// Add to the terminal output buffer, the buffer is written out when full.
+//
+//   pass: const char *s                characters
+//         int n                        number of characters
+// return: void
+//==============================================================================
+static void term_put (const char *s, int n)
+{
+ if (term_out_len + n > sizeof(term_out))
+    {
+     fwrite(term_out, 1, term_out_len, stdout);
+     term_out_len = 0;
+    }
+ memcpy(term_out + term_out_len, s, n);
+ term_out_len += n;
+}
+
+//==============================================================================
+// Move the terminal cursor unless it's already at the position.
+//
+//   pass: int row
+//         int col
+// return: void
+//==============================================================================
+static void term_goto (int row, int col)
+{
+ char s[20];
+
+ if ((row == term_cur_row) && (col == term_cur_col))
+    return;
+ term_put(s, snprintf(s, sizeof(s), "\033[%d;%dH", row + 1, col + 1));
+ term_cur_row = row;
+ term_cur_col = col;
+}
+
+//==============================================================================
+// Send the changed cells of the CRTC text screen to the terminal.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void term_draw (void)
+{
+ crtc_frame_t f;
+ int row, col;
+ int addr;
+ int c;
+ int pos;
+ char ch;
+
+ crtc_get_frame(&f);
+
+ if ((f.hdisp > TERM_COLS_MAX) || (f.vdisp > TERM_ROWS_MAX) ||
+    (f.hdisp == 0) || (f.vdisp == 0))
+    return;
+
+ // the whole terminal is drawn again if the screen size changes
+ if ((f.hdisp != term_cols) || (f.vdisp != term_rows))
+    {
+     term_cols = f.hdisp;
+     term_rows = f.vdisp;
+     memset(term_shown, 0, sizeof(term_shown));
+     term_put("\033[0m\033[2J", 8);
+     term_cur_row = -1;
+    }
+
+ addr = f.disp_start;
+ for (row = 0; row < term_rows; row++)
+    for (col = 0; col < term_cols; col++, addr++)
+       {
+        c = vdu_text_char(addr & 0x3fff);
+        if (term_shown[row * TERM_COLS_MAX + col] == c)
+           continue;
+        term_shown[row * TERM_COLS_MAX + col] = c;
+        term_goto(row, col);
+        ch = c;
+        term_put(&ch, 1);
+        term_cur_col++;
+       }
+
+ // leave the terminal cursor on the CRTC cursor if it's on the screen
+ pos = (f.cur_pos - f.disp_start) & 0x3fff;
+ if (pos < term_cols * term_rows)
+    term_goto(pos / term_cols, pos % term_cols);
+
+ if (term_out_len)
+    {
+     fwrite(term_out, 1, term_out_len, stdout);
+     fflush(stdout);
+     term_out_len = 0;
+    }
+}
+
+//==============================================================================
+// Push a key event to the SDL event queue.
+//
+//   pass: int type                     SDL_KEYDOWN or SDL_KEYUP
+//         SDLKey sym                   key
+//         SDLMod mod                   modifier keys held
+//         int unicode                  character
+// return: void
+//==============================================================================
+static void term_key_event (int type, SDLKey sym, SDLMod mod, int unicode)
+{
+ SDL_Event event;
+
+ memset(&event, 0, sizeof(event));
+ event.type = type;
+ event.key.type = type;
+ event.key.state = (type == SDL_KEYDOWN) ? SDL_PRESSED : SDL_RELEASED;
+ event.key.keysym.sym = sym;
+ event.key.keysym.mod = mod;
+ event.key.keysym.unicode = unicode;
+ SDL_PushEvent(&event);
+}
+
+//==============================================================================
+// Convert a queued key to a PC keyboard key and the modifier key needed.
+//
+//   pass: int c                        key code
+//         SDLKey *mod                  modifier key returned, SDLK_UNKNOWN if
+//                                      none
+// return: SDLKey                       key, SDLK_UNKNOWN if not supported
+//==============================================================================
+static SDLKey term_key_sym (int c, SDLKey *mod)
+{
+ char *p;
+
+ *mod = SDLK_UNKNOWN;
+
+ switch (c)
+    {
+     case TERM_KEY_UP :
+        return SDLK_UP;
+     case TERM_KEY_DOWN :
+        return SDLK_DOWN;
+     case TERM_KEY_RIGHT :
+        return SDLK_RIGHT;
+     case TERM_KEY_LEFT :
+        return SDLK_LEFT;
+     case '\r' :
+     case '\n' :
+        return SDLK_RETURN;
+     case '\t' :
+        return SDLK_TAB;
+     case 0x08 :
+     case 0x7f :
+        return SDLK_BACKSPACE;
+     case 0x1b :
+        return SDLK_ESCAPE;
+     case ' ' :
+        return SDLK_SPACE;
+    }
+
+ if ((c >= 'A') && (c <= 'Z'))
+    {
+     *mod = SDLK_LSHIFT;
+     return c - 'A' + SDLK_a;
+    }
+
+ if ((c >= 0x01) && (c <= 0x1a))
+    {
+     *mod = SDLK_LCTRL;
+     return c - 0x01 + SDLK_a;
+    }
+
+ if ((c > ' ') && (c < 0x7f))
+    {
+     p = strchr(shifted_keys, c);
+     if (p)
+        {
+         *mod = SDLK_LSHIFT;
+         return lower_keys[p - shifted_keys];
+        }
+     return c;
+    }
+
+ return SDLK_UNKNOWN;
+}
+
+//==============================================================================
+// Add a key to the key queue, the key is lost if the queue is full.
+//
+//   pass: int c                        key code
+// return: void
+//==============================================================================
+static void term_key_add (int c)
+{
+ if ((key_head - key_tail) < TERM_KEYS)
+    key_queue[key_head++ & (TERM_KEYS - 1)] = c;
+}
+
+//==============================================================================
+// Read stdin and add the keys to the key queue.
+//
+// The cursor key escape sequences are recognised, an ESC on its own is
+// passed on as a key.  CTRL+] is a prefix for terminal commands, 'q' exits
+// the emulator and a second CTRL+] passes the key on.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void term_key_read (void)
+{
+ char buf[64];
+ int n;
+ int i;
+ int c;
+
+ n = console_raw_read(buf, sizeof(buf));
+
+ for (i = 0; i < n; i++)
+    {
+     c = (uint8_t)buf[i];
+
+     if (key_prefix)
+        {
+         key_prefix = 0;
+         if ((c == 'q') || (c == 'Q'))
+            emu.done = 1;
+         else if (c == TERM_PREFIX)
+            term_key_add(c);
+         continue;
+        }
+
+     switch (key_esc)
+        {
+         case 1 :
+            key_esc = 0;
+            if ((c == '[') || (c == 'O'))
+               {
+                key_esc = 2;
+                continue;
+               }
+            term_key_add(0x1b);
+            break;
+         case 2 :
+            key_esc = 0;
+            if ((c >= 'A') && (c <= 'D'))
+               term_key_add(TERM_KEY_UP + c - 'A');
+            continue;
+        }
+
+     if (c == 0x1b)
+        key_esc = 1;
+     else if (c == TERM_PREFIX)
+        key_prefix = 1;
+     else
+        term_key_add(c);
+    }
+
+ // an ESC with nothing following it is the ESC key
+ if (key_esc == 1)
+    {
+     key_esc = 0;
+     term_key_add(0x1b);
+    }
+}
+
+//==============================================================================
+// Press and release the queued keys.  A key and its modifier key are held
+// down for TERM_KEY_HOLD frames and released for TERM_KEY_GAP frames before
+// the next key.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void term_key_update (void)
+{
+ SDLMod mod;
+ int c;
+
+ if (key_frames)
+    {
+     if (--key_frames == TERM_KEY_GAP)
+        {
+         mod = (key_mod == SDLK_LSHIFT) ? KMOD_LSHIFT :
+               (key_mod == SDLK_LCTRL) ? KMOD_LCTRL : KMOD_NONE;
+         term_key_event(SDL_KEYUP, key_sym, mod, 0);
+         if (key_mod != SDLK_UNKNOWN)
+            term_key_event(SDL_KEYUP, key_mod, KMOD_NONE, 0);
+        }
+     return;
+    }
+
+ while (key_tail != key_head)
+    {
+     c = key_queue[key_tail++ & (TERM_KEYS - 1)];
+     key_sym = term_key_sym(c, &key_mod);
+     if (key_sym == SDLK_UNKNOWN)
+        continue;
+     mod = (key_mod == SDLK_LSHIFT) ? KMOD_LSHIFT :
+           (key_mod == SDLK_LCTRL) ? KMOD_LCTRL : KMOD_NONE;
+     if (key_mod != SDLK_UNKNOWN)
+        term_key_event(SDL_KEYDOWN, key_mod, mod, 0);
+     term_key_event(SDL_KEYDOWN, key_sym, mod, (c < 0x80) ? c : 0);
+     key_frames = TERM_KEY_HOLD + TERM_KEY_GAP;
+     break;
+    }
+}
+
+//==============================================================================
+// Terminal update.  This is called for each emulated frame.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void term_update (void)
+{
+ if (! term.active)
+    return;
+
+ if (term.raw)
+    {
+     term_key_read();
+     term_key_update();
+    }
+
+ term_draw();
+}
@@ -0,0 +1,40 @@
+/* TERM Header */
+
+#ifndef HEADER_TERM_H
+#define HEADER_TERM_H
+
+#include <stdint.h>
+
+// largest CRTC text screen the terminal can show (R1 and R6 limits)
+#define TERM_COLS_MAX 256
+#define TERM_ROWS_MAX 128
+
+// size of the key queue, must be a power of 2
+#define TERM_KEYS 256
+
+// number of frames a key is held down and then released for
+#define TERM_KEY_HOLD 3
+#define TERM_KEY_GAP 1
+
+// key codes above the ASCII range
+#define TERM_KEY_UP    0x100
+#define TERM_KEY_DOWN  0x101
+#define TERM_KEY_RIGHT 0x102
+#define TERM_KEY_LEFT  0x103
+
+// terminal command prefix key (CTRL+])
+#define TERM_PREFIX    0x1d
+
+int term_init (void);
+int term_deinit (void);
+void term_update (void);
+
+typedef struct term_t
+{
+ int enable;                    /* --term option */
+ int active;                    /* terminal is being drawn */
+ int raw;                       /* stdin is in raw mode */
+ int streams;                   /* console streams before starting */
+}term_t;
+
+#endif     /* HEADER_TERM_H */
@@ -31,6 +31,21 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - init() calls term_init() and deinit() calls term_deinit() for the text
+//   terminal frontend.
+// - init() calls capture_init() and deinit() calls capture_deinit() before
+//   video_deinit() so the exit screen hash and screenshot can be made.
+// - The paused state now blocks in input_idle() until an event arrives and
+//   emulation_delay() no longer adds a frame delay when paused.
+// - Events are now obtained from the input module with input_poll_event().
+//   If the --input-thread option is used SDL is initialised with its own
+//   event thread and input_init() starts the input thread.
+// - event_handler() passes SDL_ACTIVEEVENT to video_active_event() so that
+//   nothing is drawn while the window is iconified.
+// - deinit() now calls video_deinit() before the modules are de-initialised
+//   so that the video render thread is stopped first.
+//
 // v6.0.0 - 5 February 2017, uBee
 // - Added in main() a new test for 'emu.exit_warning'.
 // v6.0.0 - 1 January 2017, K Duckmanton
@@ -454,6 +469,9 @@
 #include "keystd.h"
 #include "sn76489an.h"
 #include "console.h"
+#include "input.h"
+#include "capture.h"
+#include "term.h"
 
 #include "macros.h"
 
@@ -689,6 +707,7 @@ extern serial_t serial;
 extern joystick_t joystick;
 extern keystd_t keystd;
 extern debug_t debug;
+extern input_t input;
 
 //==============================================================================
 // External GUI signal handler.
@@ -1342,7 +1361,21 @@ static int init (void)
  putenv("SDL_VIDEO_X11_WMCLASS=ubee512");
 #endif
 
- if (SDL_Init(sdl_init_properties) != 0)
+ // the input thread requires SDL to pump events on its own thread, not all
+ // platforms support this so fall back to polling if it fails.
+ if (input.thread)
+    {
+     if (SDL_Init(sdl_init_properties | SDL_INIT_EVENTTHREAD) == 0)
+        sdl_init_properties |= SDL_INIT_EVENTTHREAD;
+     else
+        {
+         xprintf("init: SDL event thread not supported, --input-thread ignored\n");
+         input.thread = 0;
+        }
+    }
+
+ if (! (sdl_init_properties & SDL_INIT_EVENTTHREAD) &&
+    SDL_Init(sdl_init_properties) != 0)
     {
      xprintf("init: Failed SDL_Init - %s\n", SDL_GetError());
      return -1;
@@ -1377,6 +1410,15 @@ static int init (void)
      return -1;
     }
 
+ if (input_init() != 0)
+    return -1;
+
+ if (capture_init() != 0)
+    return -1;
+
+ if (term_init() != 0)
+    return -1;
+
  return 0;
 }
 
@@ -1412,6 +1454,10 @@ static int deinit (void)
  int i = 0;
 
  log_deinit();
+ input_deinit();
+ capture_deinit();
+ term_deinit();
+ video_deinit();
 
  if ((i = deinit_modules(EMU_INIT)))
     {
@@ -1602,7 +1648,7 @@ static void application_setup (void)
 //==============================================================================
 void event_handler (void)
 {
- while (SDL_PollEvent(&emu.event))
+ while (input_poll_event(&emu.event))
     {
      switch (emu.event.type)
         {
@@ -1645,6 +1691,10 @@ void event_handler (void)
                gui_mousemotion_event();
             break;
 
+         case SDL_ACTIVEEVENT:
+            video_active_event();
+            break;
+
 #ifdef USE_OPENGL
          case SDL_VIDEOEXPOSE:
             if (video.type >= VIDEO_GL)
@@ -1785,6 +1835,13 @@ static void normal_execution_loop (void)
 //==============================================================================
 static void emulation_delay (void)
 {
+ // the paused state has already waited in input_idle()
+ if (emu.paused)
+    {
+     delay_adj = 0;
+     return;
+    }
+
  if (emu.turbo)
     {
      time_delay_ms(0);
@@ -1888,6 +1945,7 @@ static void application_loop (void)
      // if emulator is in a paused state
      if (emu.paused)
         {
+         input_idle();
          keyb_update();
          event_handler();
         }
@@ -37,6 +37,60 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Added vdu_text_char() to decode a screen location as text.
+// - vdu_colcont_w() logs the write for the CRTC raster mode and added
+//   vdu_render_colour_cont() so bands of a frame can be drawn with their
+//   own colour control value.
+// - Added a frame difference mode (--video-diff).  Screen, attribute and
+//   colour RAM writes are plain stores and vdu_frame_diff() compares shadow
+//   copies with the live RAM each frame, 64 locations at a time with the
+//   expand module compare, to set the redraw flags.
+// - The screen locations with the flashing attribute bit set are kept in a
+//   bitset updated with the PCG glyph index.  vdu_propagate_flashing_attr()
+//   takes the locations from it instead of testing attribute RAM for every
+//   displayed location on each flash toggle.
+// - Added vdu_set_palette() for an 8 bit indexed display surface.  The
+//   glyph cache pixel values are then the colour indexes, the colour
+//   tables, monitor type and the 56k colour board background intensity bits
+//   only change the palette and no longer need the display redrawn.
+//   vdu_setcolourtable() returns whether a redraw is needed.
+// - The colour index lookup in vdu_draw_char() is moved to vdu_colour_pair()
+//   so the OpenGL text renderer can build its colour lookup table.
+// - Character rows are now expanded by the expand module for the character
+//   surface, the glyph cache and cursor cells, which are drawn directly to
+//   the display surface instead of with three blits.  The unimplemented
+//   16 and 24 bpp cases in vdu_expand_char_data() are removed as the
+//   character surface is always 8 bpp.
+// - Added a glyph cache holding characters expanded to the display surface
+//   pixel format for each colour pair in use.  vdu_draw_char() copies the
+//   cached rows for cells without a cursor instead of changing the character
+//   surface palette and making a blit for each cell.  Entries are recycled
+//   in least recently used order and a per glyph generation number detects
+//   changed PCG glyphs.
+// - PCG writes no longer convert the byte into the character surface, the
+//   glyph is marked in the pcg_redraw bitset and all changed glyphs are
+//   converted in one batch under a single surface lock by
+//   vdu_propagate_pcg_updates() before the frame is drawn.
+// - Added an index from each PCG glyph to the screen locations that display
+//   it, kept up to date as screen and attribute RAM is written.  A write to
+//   a PCG glyph now sets the redraw flags of just those locations and
+//   vdu_propagate_pcg_updates() no longer scans the screen each frame.
+//   The index is only rebuilt by port 0x1C when the extended graphics
+//   select changes as the bank select does not affect it.
+// - The redraw flags are now a bitset with a summary bit for each 64 bit
+//   word.  vdu_redraw_take() returns and clears the flags for up to 64
+//   locations at a time so crtc_render() can skip clean cells with a single
+//   test, and vdu_redraw_pending() allows a clean frame to be skipped.
+//   vdu_redraw_next() uses the summary bits to find the next flagged
+//   location so crtc_render() can pass over clean rows.
+//   vdu_char_is_redrawn() and vdu_char_clear_redraw() are removed.
+// - Added a render side copy of the VDU state (vdr).  When the video render
+//   thread is enabled the character drawing functions work from a snapshot
+//   taken with vdu_snapshot() at each frame boundary, and PCG glyphs are
+//   converted into the character surface from the snapshot rather than on
+//   every Z80 write.
+//
 // v6.0.0 - 1 January 2017, K Duckmanton
 // - Microbee memory is now an array of uint8_t rather than char.
 // - Refactored this module to only redraw those parts of the screen that
@@ -180,10 +234,12 @@
 //==============================================================================
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <SDL.h>
 
 #include "vdu.h"
+#include "expand.h"
 #include "crtc.h"
 #include "video.h"
 #include "z80.h"
@@ -208,12 +264,71 @@
 #define CHAR_SURFACE_ROM_BANK(x)             (x)
 #define CHAR_SURFACE_PCG_BANK(x)             ((x) + CHAR_SURFACE_ROM_BANKS)
 
+// mask of the n (0-64) lowest bits
+#define VDU_REDRAW_BITS(n) (((n) >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << (n)) - 1))
+
 
 //==============================================================================
 // structures and variables
 //==============================================================================
 vdu_t vdu;
 
+// The render side VDU state.  This is the live state unless the video
+// render thread is in use, in which case it points to a snapshot that is
+// only updated at frame boundaries by vdu_snapshot().
+static vdu_t vdu_snap;
+static vdu_t *vdr = &vdu;
+static int vdu_snap_full;
+
+// Index from a PCG glyph (bank * 128 + character) to the screen locations
+// that display it.  Each glyph heads a doubly linked list of screen RAM
+// indexes, -1 ends a list or marks a location that shows no PCG glyph.
+static int16_t pcg_cell_head[PCG_RAM_SIZE / 16];
+static int16_t pcg_cell_next[SCR_RAM_SIZE];
+static int16_t pcg_cell_prev[SCR_RAM_SIZE];
+static int16_t pcg_cell_glyph[SCR_RAM_SIZE];
+
+// Screen locations with the flashing attribute bit set, kept with the PCG
+// glyph index so a flash toggle doesn't need to scan attribute RAM.
+static uint64_t flash_cell[VDU_REDRAW_WORDS];
+
+// Frame difference mode shadow RAM, see vdu_frame_diff()
+static uint8_t diff_scr[SCR_RAM_SIZE];
+static uint8_t diff_att[ATT_RAM_SIZE];
+static uint8_t diff_col[COL_RAM_SIZE];
+
+static void vdu_diff_init (void);
+
+// Glyph cache, see vdu_glyph_cache_flush()
+#define VDU_GCACHE_ENTRIES 1024
+#define VDU_GCACHE_HASH_BITS 11
+#define VDU_GCACHE_BUCKETS (1 << VDU_GCACHE_HASH_BITS)
+#define VDU_GCACHE_NOKEY 0xffffffff
+
+static vdu_glyph_t gcache[VDU_GCACHE_ENTRIES];
+static int16_t gcache_bucket[VDU_GCACHE_BUCKETS];
+static int gcache_head;
+static int gcache_tail;
+static int gcache_valid;
+static int gcache_bpp;          /* bytes per pixel, 0 if not usable */
+static int gcache_rows;         /* pixel rows in a glyph */
+static int gcache_size;
+static uint8_t *gcache_pixels;
+static uint32_t gcache_colour[VDU_PAL_CUBE];
+
+//==============================================================================
+// Set the redraw flag for a screen location.
+//
+//   pass: vdu_t *v                     VDU state
+//         int idx                      screen RAM index
+// return: void
+//==============================================================================
+static inline void vdu_redraw_set (vdu_t *v, int idx)
+{
+ v->redraw[idx >> 6] |= (uint64_t)1 << (idx & 63);
+ v->redraw_sum[idx >> 12] |= (uint64_t)1 << ((idx >> 6) & 63);
+}
+
 extern emu_t emu;
 extern model_t modelx;
 extern model_custom_t modelc;
@@ -226,6 +341,11 @@ extern int basofs;              /* offset into alpha+ BASIC ROM */
 
 SDL_Surface *char_data;
 
+static void vdu_expand_char_data (int bank, int offset, uint8_t *data, int numbytes);
+
+// generation number of each glyph in the character surface
+static uint16_t glyph_gen[CHAR_SURFACE_NUM_BANKS * CHAR_SURFACE_BANK_SIZE];
+
 //==============================================================================
 //
 // Available colours for each colour model
@@ -711,14 +831,18 @@ int vdu_init (void)
     }
 
  memset(vdu.redraw, 0, sizeof(vdu.redraw));
+ memset(vdu.redraw_sum, 0, sizeof(vdu.redraw_sum));
 
  vdu.scr_ptr = vdu.scr_ram;
  vdu.atr_ptr = vdu.att_ram;
  vdu.col_ptr = vdu.col_ram;
  vdu.pcg_ptr = vdu.pcg_ram;
- vdu.redraw_ptr = vdu.redraw;
+ vdu.redraw_ofs = 0;
  vdu.scr_mask = ~(~0 << 11);
 
+ vdu_pcg_index_rebuild();
+ vdu_diff_init();
+
  vdu_setcolourtable();
  vdu_create_char_surface();
  vdu_fill_char_surface();
@@ -735,6 +859,10 @@ int vdu_init (void)
 int vdu_deinit (void)
 {
  vdu_destroy_char_surface();
+ free(gcache_pixels);
+ gcache_pixels = NULL;
+ gcache_size = 0;
+ gcache_valid = 0;
  return 0;
 }
 
@@ -766,9 +894,172 @@ int vdu_reset (void)
 
  vdu.scr_mask = ~(~0 << 11);
 
+ vdu_pcg_index_rebuild();
+
  return 0;
 }
 
+//==============================================================================
+// Index the PCG glyph shown at a screen location.
+//
+// Moves the location to the list of the glyph it now displays.  A location
+// displays a PCG glyph if bit 7 of the character is set, the bank comes from
+// attribute RAM when the extended graphics are enabled.  The location's
+// flashing attribute bit is also recorded.
+//
+//   pass: int idx                      screen RAM index
+// return: void
+//==============================================================================
+static void vdu_pcg_index_cell (int idx)
+{
+ int data = vdu.scr_ram[idx];
+ int glyph = -1;
+ int bank;
+
+ if (vdu.att_ram[idx] & B8(10000000))
+    flash_cell[idx >> 6] |= (uint64_t)1 << (idx & 63);
+ else
+    flash_cell[idx >> 6] &= ~((uint64_t)1 << (idx & 63));
+
+ if (data & 0x80)
+    {
+     bank = (vdu.extendram) ? (vdu.att_ram[idx] & B8(00001111)) : 0;
+     if (bank < modelx.pcg)
+        glyph = bank * 128 + (data & 0x7f);
+    }
+
+ if (glyph == pcg_cell_glyph[idx])
+    return;
+
+ // unlink from the old glyph
+ if (pcg_cell_glyph[idx] != -1)
+    {
+     if (pcg_cell_prev[idx] != -1)
+        pcg_cell_next[pcg_cell_prev[idx]] = pcg_cell_next[idx];
+     else
+        pcg_cell_head[pcg_cell_glyph[idx]] = pcg_cell_next[idx];
+     if (pcg_cell_next[idx] != -1)
+        pcg_cell_prev[pcg_cell_next[idx]] = pcg_cell_prev[idx];
+    }
+
+ // link to the new glyph
+ pcg_cell_glyph[idx] = glyph;
+ if (glyph != -1)
+    {
+     pcg_cell_prev[idx] = -1;
+     pcg_cell_next[idx] = pcg_cell_head[glyph];
+     if (pcg_cell_head[glyph] != -1)
+        pcg_cell_prev[pcg_cell_head[glyph]] = idx;
+     pcg_cell_head[glyph] = idx;
+    }
+}
+
+//==============================================================================
+// Rebuild the PCG glyph index.
+//
+// Must be called when screen or attribute RAM is changed other than by a Z80
+// write or when the extended graphics mode changes.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void vdu_pcg_index_rebuild (void)
+{
+ int i;
+
+ memset(pcg_cell_head, 0xff, sizeof(pcg_cell_head));
+ memset(pcg_cell_glyph, 0xff, sizeof(pcg_cell_glyph));
+
+ for (i = 0; i < SCR_RAM_SIZE; i++)
+    vdu_pcg_index_cell(i);
+}
+
+//==============================================================================
+// Frame difference mode (--video-diff).
+//
+// Z80 writes to screen, attribute and colour RAM are plain stores.  A shadow
+// copy of each is compared with the live RAM once per frame by
+// vdu_frame_diff() and the locations that differ have their redraw flags
+// set and are indexed again.  Programs that write the same screen area many
+// times in a frame then cost one compare per location per frame.  The
+// compare is done 64 locations at a time by expand_diff64_p().
+//==============================================================================
+
+//==============================================================================
+// Set up frame difference mode.  The shadow copies start the same as the
+// live RAM as the whole display is drawn after initialisation.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void vdu_diff_init (void)
+{
+ if (! video.diff)
+    return;
+
+ memcpy(diff_scr, vdu.scr_ram, sizeof(diff_scr));
+ memcpy(diff_att, vdu.att_ram, sizeof(diff_att));
+ memcpy(diff_col, vdu.col_ram, sizeof(diff_col));
+}
+
+//==============================================================================
+// Find the screen locations changed since the last frame in frame
+// difference mode.  Called at each frame boundary before the redraw flags
+// are used.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void vdu_frame_diff (void)
+{
+ uint64_t scr;
+ uint64_t att;
+ uint64_t bits;
+ int words;
+ int w;
+ int i;
+
+ if (! video.diff)
+    return;
+
+ // standard models only have the first 2K
+ words = modelx.alphap ? VDU_REDRAW_WORDS : 0x0800 / 64;
+
+ for (w = 0, i = 0; w < words; w++, i += 64)
+    {
+     scr = expand_diff64_p(diff_scr + i, vdu.scr_ram + i);
+     att = expand_diff64_p(diff_att + i, vdu.att_ram + i);
+     bits = scr | att | expand_diff64_p(diff_col + i, vdu.col_ram + i);
+     if (! bits)
+        continue;
+
+     vdu.redraw[w] |= bits;
+     vdu.redraw_sum[w >> 6] |= (uint64_t)1 << (w & 63);
+
+     // the PCG glyph shown and flashing attribute may have changed
+     bits = scr | att;
+     while (bits)
+        {
+         vdu_pcg_index_cell(i + __builtin_ctzll(bits));
+         bits &= bits - 1;
+        }
+    }
+}
+
+//==============================================================================
+// Set the redraw flag of each screen location that displays a PCG glyph.
+//
+//   pass: int glyph                    bank * 128 + character
+// return: void
+//==============================================================================
+static void vdu_pcg_redraw_cells (int glyph)
+{
+ int idx;
+
+ for (idx = pcg_cell_head[glyph]; idx != -1; idx = pcg_cell_next[idx])
+    vdu_redraw_set(&vdu, idx);
+}
+
 //==============================================================================
 // Video memory read.
 //
@@ -830,6 +1121,7 @@ void vdu_vidmem_w (uint32_t addr, uint8_t data,
                    struct z80_memory_write_byte *mem_s)
 {
  uint8_t *vidmem_ptr;
+ int i;
 
 #if 0
  if (modio.vdumem)
@@ -862,15 +1154,24 @@ void vdu_vidmem_w (uint32_t addr, uint8_t data,
                                  * screen location doesn't change. */
  if (!vdu.colourram && (addr & 0x0800))
     {
-     // PCG write
-     vdu_write_pcg_data(vdu.videobank, addr & 0x07FF, &data, 1);
-     vdu.pcg_redraw[vdu.videobank * 128 + (addr & 0x07ff) / 16] = 1;
+     // PCG write, the glyph is converted when the next frame is drawn
+     i = vdu.videobank * 128 + (addr & 0x07ff) / 16;
+     if (! (vdu.pcg_redraw[i >> 6] & ((uint64_t)1 << (i & 63))))
+        {
+         vdu.pcg_redraw[i >> 6] |= (uint64_t)1 << (i & 63);
+         vdu_pcg_redraw_cells(i);
+        }
+     *vidmem_ptr = data;
     }
+ else if (video.diff)
+    *vidmem_ptr = data;         /* found by vdu_frame_diff() */
  else
     {
-     vdu.redraw_ptr[addr & 0x07FF] = 1; /* note that this screen location needs to be redrawn */
+     vdu_redraw_set(&vdu, vdu.redraw_ofs + (addr & 0x07FF)); /* note that this screen location needs to be redrawn */
+     *vidmem_ptr = data;
+     if (! (addr & 0x0800))
+        vdu_pcg_index_cell(vdu.redraw_ofs + (addr & 0x07FF));
     }
- *vidmem_ptr = data;
  /*
   * Rendering of the changed character is deferred to the "update
   * interval"
@@ -936,16 +1237,23 @@ void vdu_colcont_w (uint16_t port, uint8_t data, struct z80_port_write *port_s)
      if (modelx.colour == 1)    /* FIXME: this should be an ENUM */
         {
          // If any of the RGB background intensity bits have changed,
-         // the entire screen must be redrawn.
+         // the entire screen must be redrawn, or only the palette set for
+         // an indexed surface.
          if ((vdu.x_colour_cont & B8(00001110)) !=
              (vdu.colour_cont & B8(00001110)))
-            crtc_set_redraw();
+            {
+             if (video.indexed)
+                vdu_set_palette();
+             else
+                crtc_set_redraw();
+            }
         }
 
      if ((vdu.x_colour_cont & B8(01000000)) != (vdu.colour_cont & B8(01000000)))
        vdu.colourram = vdu.colour_cont & B8(01000000);
 
      vdu.x_colour_cont = vdu.colour_cont;
+     crtc_raster_write();
     }
  else
     crtc_set_redraw();  // see above for the reason
@@ -1042,7 +1350,10 @@ void vdu_lvdat_w (uint16_t port, uint8_t data, struct z80_port_write *port_s)
      vdu.atr_ptr = vdu.att_ram + (vdu.videobank & modelx.vdu) * 0x0800;
      vdu.col_ptr = vdu.col_ram + (vdu.videobank & modelx.vdu) * 0x0800;
      vdu.pcg_ptr = (vdu.videobank >= modelx.pcg) ? NULL : vdu.pcg_ram + vdu.videobank * 0x800;
-     vdu.redraw_ptr = vdu.redraw + (vdu.videobank & modelx.vdu) * 0x0800; 
+     vdu.redraw_ofs = (vdu.videobank & modelx.vdu) * 0x0800;
+     // the index covers all banks so only the PCG bank source matters
+     if ((vdu.x_lv_dat ^ vdu.lv_dat) & B8(10000000))
+        vdu_pcg_index_rebuild();
      crtc_set_redraw();
     }
  vdu.x_lv_dat = vdu.lv_dat;                         // port (0x1c) value
@@ -1066,44 +1377,82 @@ void vdu_latchrom_w (uint16_t port, uint8_t data, struct z80_port_write *port_s)
 
 
 //==============================================================================
+// Propagate updates to the PCG RAM.
 //
-// Propagate updates to the PCG ram back to the screen RAM
+// The redraw flags of the screen locations using a changed glyph were set
+// when the glyph was written.  The changed glyphs are converted into the
+// character surface here with the surface locked only once.
 //
+//   pass: void
+// return: void
 //==============================================================================
-void vdu_propagate_pcg_updates(int maddr, int size)
+void vdu_propagate_pcg_updates (void)
 {
- int pcgbank;
- uint8_t data;
+ int w;
+ int i;
+ int locked = 0;
+ uint64_t bits;
 
- for (; size > 0; ++maddr, --size)
+ for (w = 0; w < VDU_PCG_WORDS; w++)
     {
-     data = vdu.scr_ram[maddr & vdu.scr_mask];
-     if (!(data & 0x80))
+     bits = vdr->pcg_redraw[w];
+     if (! bits)
         continue;
-     pcgbank = (vdu.extendram) ? (vdu.att_ram[maddr & vdu.scr_mask] & B8(00001111)) : 0;
-     if (pcgbank >= modelx.pcg)
-        continue;               /* The selected PCG bank isn't
-                                 * physically present, so it cannot be
-                                 * updated. */
-     if (vdu.pcg_redraw[pcgbank * 128 + (data & 0x7f)])
-        vdu_redraw_char(maddr);
+     vdr->pcg_redraw[w] = 0;
+     if (! locked)
+        {
+         SDL_LockSurface(char_data);
+         locked = 1;
+        }
+     while (bits)
+        {
+         i = w * 64 + __builtin_ctzll(bits);
+         bits &= bits - 1;
+         vdu_expand_char_data(CHAR_SURFACE_PCG_BANK(i / 128), (i % 128) * 16,
+                              vdr->pcg_ram + i * 16, 16);
+        }
     }
- memset(vdu.pcg_redraw, 0, sizeof(vdu.pcg_redraw));
+
+ if (locked)
+    SDL_UnlockSurface(char_data);
 }
 
 //==============================================================================
+// Propagate the flashing attribute bit.
 //
-// Propagate the flashing attribute bit
+// Sets the redraw flag of the displayed locations that have the flashing
+// attribute bit set.  The locations are taken from the flash set 64 at a
+// time rather than testing attribute RAM.
 //
+//   pass: int maddr                    first displayed CRTC address
+//         int size                     number of displayed locations
+// return: void
 //==============================================================================
-void vdu_propagate_flashing_attr(int maddr, int size)
+void vdu_propagate_flashing_attr (int maddr, int size)
 {
+ uint64_t bits;
+ int idx;
+ int n;
+
  if (!(vdu.extendram))
     return;                     /* premium graphics not enabled */
- for (; size > 0; ++maddr, --size)
+
+ while (size > 0)
     {
-     if (vdu.att_ram[maddr & vdu.scr_mask] & B8(10000000))
-        vdu_redraw_char(maddr);
+     idx = maddr & vdu.scr_mask;
+     n = 64 - (idx & 63);
+     if (n > size)
+        n = size;
+     bits = flash_cell[idx >> 6] >> (idx & 63);
+     if (n < 64)
+        bits &= ((uint64_t)1 << n) - 1;
+     while (bits)
+        {
+         vdu_redraw_set(&vdu, idx + __builtin_ctzll(bits));
+         bits &= bits - 1;
+        }
+     maddr += n;
+     size -= n;
     }
 }
 
@@ -1112,23 +1461,236 @@ void vdu_propagate_flashing_attr(int maddr, int size)
  */
 void vdu_redraw_char(int maddr)
 {
- vdu.redraw[maddr & vdu.scr_mask] = 1;
+ vdu_redraw_set(&vdu, maddr & vdu.scr_mask);
 }
 
-/*
- * Test whether the character at screen location addr must be redrawn
- */
-uint8_t vdu_char_is_redrawn(int maddr)
+//==============================================================================
+// Test if any screen location needs to be redrawn.
+//
+//   pass: void
+// return: int                          non zero if a redraw flag is set
+//==============================================================================
+int vdu_redraw_pending (void)
 {
- return vdu.redraw[maddr & vdu.scr_mask];
+ int i;
+
+ for (i = 0; i < VDU_REDRAW_SUMS; i++)
+    if (vdr->redraw_sum[i])
+       return 1;
+ return 0;
 }
 
-/*
- * Note that the character at screen location addr has been redrawn
- */
-void vdu_char_clear_redraw(int maddr)
+//==============================================================================
+// Take the redraw flags for a run of screen locations.
+//
+// Returns the flags for n consecutive locations starting at maddr, bit 0
+// being maddr, and clears them.  The run wraps around at the end of the
+// screen RAM the same way the CRTC address does.
+//
+//   pass: int maddr                    CRTC address of the first location
+//         int n                        number of locations (1-64)
+// return: uint64_t                     redraw flags
+//==============================================================================
+uint64_t vdu_redraw_take (int maddr, int n)
+{
+ int idx = maddr & vdr->scr_mask;
+ int w = idx >> 6;
+ int b = idx & 63;
+ int k = 64 - b;
+ uint64_t bits;
+ uint64_t m;
+
+ if (k > n)
+    k = n;
+
+ m = VDU_REDRAW_BITS(k);
+ bits = (vdr->redraw[w] >> b) & m;
+ if (bits)
+    {
+     vdr->redraw[w] &= ~(m << b);
+     if (! vdr->redraw[w])
+        vdr->redraw_sum[w >> 6] &= ~((uint64_t)1 << (w & 63));
+    }
+
+ // the rest of the run starts on a word boundary
+ if (k < n)
+    {
+     w = ((idx + k) & vdr->scr_mask) >> 6;
+     m = VDU_REDRAW_BITS(n - k);
+     if (vdr->redraw[w] & m)
+        {
+         bits |= (vdr->redraw[w] & m) << k;
+         vdr->redraw[w] &= ~m;
+         if (! vdr->redraw[w])
+            vdr->redraw_sum[w >> 6] &= ~((uint64_t)1 << (w & 63));
+        }
+    }
+
+ return bits;
+}
+
+//==============================================================================
+// Find the next screen location that needs to be redrawn.
+//
+// The summary bits are used to pass over words with no flags set.  The
+// search goes round the screen RAM the same way the CRTC address does and
+// comes back to the locations before maddr last.
+//
+//   pass: int maddr                    CRTC address to search from
+// return: int                          number of locations from maddr to the
+//                                      next flagged location, -1 if none
+//==============================================================================
+int vdu_redraw_next (int maddr)
+{
+ int idx = maddr & vdr->scr_mask;
+ int words = (vdr->scr_mask >> 6) + 1;
+ int b = idx & 63;
+ int n, k, w;
+ uint64_t bits;
+
+ bits = vdr->redraw[idx >> 6] >> b;
+ if (bits)
+    return __builtin_ctzll(bits);
+
+ for (n = 1; n <= words; n += k)
+    {
+     w = ((idx >> 6) + n) & (words - 1);
+     k = 64 - (w & 63);
+     if (k > words - w)
+        k = words - w;
+     bits = (vdr->redraw_sum[w >> 6] >> (w & 63)) & VDU_REDRAW_BITS(k);
+     if (bits)
+        {
+         k = __builtin_ctzll(bits);
+         if (n + k > words)
+            break;
+         return (n + k) * 64 - b + __builtin_ctzll(vdr->redraw[w + k]);
+        }
+    }
+
+ return -1;
+}
+
+//==============================================================================
+// Select whether the character drawing functions use the live VDU state or
+// a snapshot of it.  The snapshot is used when rendering is carried out on
+// a separate thread.
+//
+//   pass: int enable                   1 to draw from a snapshot
+// return: void
+//==============================================================================
+void vdu_snapshot_mode (int enable)
+{
+ vdr = enable ? &vdu_snap : &vdu;
+ vdu_snap_full = enable;
+}
+
+//==============================================================================
+// Set the colour control value characters are drawn with.  Used by the CRTC
+// raster mode to draw bands of a frame with different values.
+//
+//   pass: int colour_cont              colour control port value
+// return: uint8_t                      previous value
+//==============================================================================
+uint8_t vdu_render_colour_cont (int colour_cont)
+{
+ uint8_t x = vdr->colour_cont;
+
+ vdr->colour_cont = colour_cont;
+
+ return x;
+}
+
+//==============================================================================
+// Take a snapshot of the VDU state for the renderer.
+//
+// Called by the emulation thread at a frame boundary while the renderer is
+// idle.  The redraw flags are moved into the snapshot so that cells changed
+// while the renderer was busy accumulate until the next snapshot.  Only the
+// PCG glyphs that have changed are copied.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void vdu_snapshot (void)
+{
+ int i;
+ int g;
+ uint64_t bits;
+
+ if (vdr == &vdu)
+    return;
+
+ if (vdu_snap_full)
+    {
+     memcpy(&vdu_snap, &vdu, sizeof(vdu_snap));
+     vdu_snap_full = 0;
+    }
+ else
+    {
+     memcpy(vdu_snap.scr_ram, vdu.scr_ram, sizeof(vdu_snap.scr_ram));
+     memcpy(vdu_snap.att_ram, vdu.att_ram, sizeof(vdu_snap.att_ram));
+     memcpy(vdu_snap.col_ram, vdu.col_ram, sizeof(vdu_snap.col_ram));
+     for (i = 0; i < VDU_PCG_WORDS; i++)
+        {
+         bits = vdu.pcg_redraw[i];
+         vdu_snap.pcg_redraw[i] |= bits;
+         while (bits)
+            {
+             g = i * 64 + __builtin_ctzll(bits);
+             bits &= bits - 1;
+             memcpy(vdu_snap.pcg_ram + g * 16, vdu.pcg_ram + g * 16, 16);
+            }
+        }
+     for (i = 0; i < VDU_REDRAW_WORDS; i++)
+        if (vdu.redraw_sum[i >> 6] & ((uint64_t)1 << (i & 63)))
+           vdu_snap.redraw[i] |= vdu.redraw[i];
+     for (i = 0; i < VDU_REDRAW_SUMS; i++)
+        vdu_snap.redraw_sum[i] |= vdu.redraw_sum[i];
+     vdu_snap.colour_cont = vdu.colour_cont;
+     vdu_snap.extendram = vdu.extendram;
+     vdu_snap.scr_mask = vdu.scr_mask;
+    }
+
+ memset(vdu.redraw, 0, sizeof(vdu.redraw));
+ memset(vdu.redraw_sum, 0, sizeof(vdu.redraw_sum));
+ memset(vdu.pcg_redraw, 0, sizeof(vdu.pcg_redraw));
+}
+
+//==============================================================================
+// Get the character at a screen location as text.
+//
+// Characters from the character ROM are returned as ASCII with control
+// codes as a space.  PCG characters are returned as VDU_TEXT_PCG unless the
+// glyph is blank or the PCG bank is not fitted.
+//
+//   pass: int addr                     CRTC address
+// return: int                          character
+//==============================================================================
+int vdu_text_char (int addr)
 {
- vdu.redraw[maddr & vdu.scr_mask] = 0;
+ uint8_t ch;
+ uint8_t *g;
+ int bank;
+ int i;
+
+ ch = vdu.scr_ram[addr & vdu.scr_mask];
+
+ if (ch & 0x80)
+    {
+     bank = vdu.extendram ? (vdu.att_ram[addr & vdu.scr_mask] & B8(00001111)) : 0;
+     if (bank >= modelx.pcg)
+        return ' ';
+     g = vdu.pcg_ram + bank * 0x0800 + (ch & 0x7f) * 16;
+     for (i = 0; i < 16; i++)
+        if (g[i])
+           return VDU_TEXT_PCG;
+     return ' ';
+    }
+
+ if ((ch < 0x20) || (ch == 0x7f))
+    return ' ';
+ return ch;
 }
 
 //==============================================================================
@@ -1151,47 +1713,334 @@ void vdu_write_pcg_data(int bank, int offset, uint8_t *data, int numbytes)
 
 void vdu_write_char_data(int bank, int offset, uint8_t *data, int numbytes)
 {
- bank *= CHAR_SURFACE_BANK_SIZE;
  SDL_LockSurface(char_data);
+ vdu_expand_char_data(bank, offset, data, numbytes);
+ SDL_UnlockSurface(char_data);
+}
+
+//==============================================================================
+// Expand character data into the character surface.
+//
+// The surface must be locked by the caller.
+//
+//   pass: int bank                     character surface bank
+//         int offset                   byte offset into the bank
+//         uint8_t *data                character data
+//         int numbytes                 number of bytes
+// return: void
+//==============================================================================
+static void vdu_expand_char_data (int bank, int offset, uint8_t *data, int numbytes)
+{
+ bank *= CHAR_SURFACE_BANK_SIZE;
  while (numbytes)
     {
      int line = offset % 16;
      int o = bank + offset / 16;
      int x = (o % CHAR_SURFACE_WIDTH_CHARS) * 8;
      int y = (o / CHAR_SURFACE_WIDTH_CHARS) * 16 + line;
-     int y1;
-     int i;
-     uint8_t d;
+     int n = 16 - line;         /* rows to the end of this glyph */
 
+     if (n > numbytes)
+        n = numbytes;
+     glyph_gen[o]++;
      y *= char_data->pitch * video.yscale;
-     for (y1 = 0; y1 < video.yscale; ++y1, y += char_data->pitch)
+     expand_rows_p[1]((uint8_t *)char_data->pixels + y + x, char_data->pitch,
+                      data, n, video.yscale, 1, 0);
+     offset += n;
+     data += n;
+     numbytes -= n;
+    }
+}
+
+//==============================================================================
+// Glyph cache.
+//
+// Holds characters already expanded to the display surface's pixel format
+// for a foreground and background colour pair so a cell can be drawn with
+// a row copy for each scanline instead of a palette change and blit.  The
+// cache is keyed on the character surface bank, character and colour pair
+// (inverse video is a swapped pair), entries are recycled in least recently
+// used order.
+//
+// A glyph generation number is incremented when a glyph is converted into
+// the character surface so stale entries for a changed PCG glyph are
+// redrawn when next used.  The whole cache is flushed when the colour table,
+// character surface or display surface changes.
+//==============================================================================
+
+//==============================================================================
+// Flush the glyph cache.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void vdu_glyph_cache_flush (void)
+{
+ gcache_valid = 0;
+}
+
+//==============================================================================
+// Set up the glyph cache for the display surface.
+//
+//   pass: SDL_Surface *screen
+// return: int                          0 if the cache can be used, else -1
+//==============================================================================
+static int vdu_glyph_cache_setup (SDL_Surface *screen)
+{
+ uint8_t *pixels;
+ int size;
+ int i;
+
+ gcache_valid = 1;
+ gcache_bpp = screen->format->BytesPerPixel;
+ gcache_rows = 16 * video.yscale;
+
+ // 24 bpp surfaces are drawn with the blitter
+ if (gcache_bpp == 3)
+    {
+     gcache_bpp = 0;
+     return -1;
+    }
+
+ size = VDU_GCACHE_ENTRIES * gcache_rows * 8 * gcache_bpp;
+ if (size > gcache_size)
+    {
+     pixels = realloc(gcache_pixels, size);
+     if (! pixels)
         {
-         switch (char_data->format->BitsPerPixel)
-            {
-             case 1:
-                /* 1bpp is even easier! */
-                *(uint8_t *)(char_data->pixels + y + x / 8) = *data;
-                break;
-             case 8:
-                for (i = 0, d = *data; i < 8; ++i, d <<= 1)
-                   {
-                    *(uint8_t *)(char_data->pixels + y + x * 1 + i) = 
-                       (d & (1 << 7)) ? 1 : 0; 
-                   }
-                break;
-                /* other bit depths are left as an exercise for the
-                 * reader */
-             case 16:
-             case 24:
-             default:
-             break;
-            }
+         gcache_bpp = 0;
+         return -1;
         }
-     ++offset;
-     ++data;
-     --numbytes;
+     gcache_pixels = pixels;
+     gcache_size = size;
+    }
+
+ // an indexed surface's pixel values are the colour indexes
+ for (i = 0; i < VDU_PAL_CUBE; i++)
+    if (video.indexed)
+       gcache_colour[i] = i;
+    else
+       if (i < VDU_PAL_BG)
+          gcache_colour[i] = SDL_MapRGB(screen->format, col_table[i].r,
+                                        col_table[i].g, col_table[i].b);
+
+ for (i = 0; i < VDU_GCACHE_BUCKETS; i++)
+    gcache_bucket[i] = -1;
+
+ for (i = 0; i < VDU_GCACHE_ENTRIES; i++)
+    {
+     gcache[i].key = VDU_GCACHE_NOKEY;
+     gcache[i].hnext = -1;
+     gcache[i].prev = i - 1;
+     gcache[i].next = (i == VDU_GCACHE_ENTRIES - 1) ? -1 : i + 1;
+    }
+ gcache_head = 0;
+ gcache_tail = VDU_GCACHE_ENTRIES - 1;
+
+ return 0;
+}
+
+//==============================================================================
+// Get the character rows of a glyph.
+//
+//   pass: int bank                     character surface bank
+//         int ch                       character (0-127)
+// return: uint8_t *                    16 character rows
+//==============================================================================
+static uint8_t *vdu_glyph_rows (int bank, int ch)
+{
+ if (bank < CHAR_SURFACE_ROM_BANKS)
+    return vdu.chr_rom + bank * 0x0800 + ch * 16;
+ else
+    return vdr->pcg_ram + (bank - CHAR_SURFACE_ROM_BANKS) * 0x0800 + ch * 16;
+}
+
+//==============================================================================
+// Expand a glyph into a cache entry.
+//
+//   pass: int e                        cache entry
+//         int bank                     character surface bank
+//         int ch                       character (0-127)
+//         int fgc                      foreground colour index
+//         int bgc                      background colour index
+// return: void
+//==============================================================================
+static void vdu_glyph_cache_fill (int e, int bank, int ch, int fgc, int bgc)
+{
+ expand_rows_p[gcache_bpp](gcache_pixels + e * gcache_rows * 8 * gcache_bpp,
+                           8 * gcache_bpp, vdu_glyph_rows(bank, ch), 16,
+                           video.yscale, gcache_colour[fgc], gcache_colour[bgc]);
+
+ gcache[e].gen = glyph_gen[bank * CHAR_SURFACE_BANK_SIZE + ch];
+}
+
+//==============================================================================
+// Find or create the cache entry for a glyph and colour pair.
+//
+// The entry returned is moved to the head of the LRU list.
+//
+//   pass: int bank                     character surface bank
+//         int ch                       character (0-127)
+//         int fgc                      foreground colour index
+//         int bgc                      background colour index
+// return: uint8_t *                    expanded glyph pixels
+//==============================================================================
+static uint8_t *vdu_glyph_cache_get (int bank, int ch, int fgc, int bgc)
+{
+ uint32_t key = (bank << 22) | (ch << 16) | (fgc << 8) | bgc;
+ int h = (key * 2654435761u) >> (32 - VDU_GCACHE_HASH_BITS);
+ int e;
+ int16_t *pp;
+
+ for (e = gcache_bucket[h]; e != -1; e = gcache[e].hnext)
+    if (gcache[e].key == key)
+       break;
+
+ if (e == -1)
+    {
+     // recycle the least recently used entry
+     e = gcache_tail;
+     if (gcache[e].key != VDU_GCACHE_NOKEY)
+        {
+         pp = &gcache_bucket[gcache[e].hash];
+         while (*pp != e)
+            pp = &gcache[*pp].hnext;
+         *pp = gcache[e].hnext;
+        }
+     gcache[e].key = key;
+     gcache[e].hash = h;
+     gcache[e].hnext = gcache_bucket[h];
+     gcache_bucket[h] = e;
+     vdu_glyph_cache_fill(e, bank, ch, fgc, bgc);
+    }
+ else
+    if (gcache[e].gen != glyph_gen[bank * CHAR_SURFACE_BANK_SIZE + ch])
+       vdu_glyph_cache_fill(e, bank, ch, fgc, bgc);
+
+ // move to the head of the LRU list
+ if (e != gcache_head)
+    {
+     gcache[gcache[e].prev].next = gcache[e].next;
+     if (gcache[e].next != -1)
+        gcache[gcache[e].next].prev = gcache[e].prev;
+     else
+        gcache_tail = gcache[e].prev;
+     gcache[e].prev = -1;
+     gcache[e].next = gcache_head;
+     gcache[gcache_head].prev = e;
+     gcache_head = e;
+    }
+
+ return gcache_pixels + e * gcache_rows * 8 * gcache_bpp;
+}
+
+//==============================================================================
+// Draw a character without the blitter.
+//
+// A character without a visible cursor is copied from the glyph cache.  A
+// character with a cursor is expanded directly into the display surface,
+// the cursor region having the colours swapped.
+//
+//   pass: SDL_Surface *screen
+//         int x                        X pixel position
+//         int y                        Y pixel position
+//         int bank                     character surface bank
+//         int ch                       character (0-127)
+//         int fgc                      foreground colour index
+//         int bgc                      background colour index
+//         int lines                    number of character lines to draw
+//         int *regionheights           lines above, in and below the cursor
+// return: int                          0 if drawn, -1 if the blitter is needed
+//==============================================================================
+static int vdu_glyph_draw (SDL_Surface *screen, int x, int y, int bank, int ch,
+                           int fgc, int bgc, int lines, int *regionheights)
+{
+ uint8_t *src;
+ uint8_t *dst;
+ int rows = lines * video.yscale;
+ int w;
+ int i;
+
+ if ((lines > 16) || SDL_MUSTLOCK(screen) ||
+    (x + 8 > screen->w) || (y + rows > screen->h))
+    return -1;
+
+ if ((! gcache_valid) && (vdu_glyph_cache_setup(screen) == -1))
+    return -1;
+ if (! gcache_bpp)
+    return -1;
+
+ dst = (uint8_t *)screen->pixels + y * screen->pitch + x * gcache_bpp;
+
+ if (regionheights[1])
+    {
+     src = vdu_glyph_rows(bank, ch);
+     for (i = 0; i < 3; i++)
+        {
+         expand_rows_p[gcache_bpp](dst, screen->pitch, src, regionheights[i],
+                                   video.yscale,
+                                   gcache_colour[(i == 1) ? bgc : fgc],
+                                   gcache_colour[(i == 1) ? fgc : bgc]);
+         src += regionheights[i];
+         dst += regionheights[i] * video.yscale * screen->pitch;
+        }
+     return 0;
+    }
+
+ src = vdu_glyph_cache_get(bank, ch, fgc, bgc);
+ w = 8 * gcache_bpp;
+ while (rows--)
+    {
+     memcpy(dst, src, w);
+     src += w;
+     dst += screen->pitch;
+    }
+
+ return 0;
+}
+
+//==============================================================================
+// Get the foreground and background colour table indexes for a colour RAM
+// value.
+//
+//   pass: uint8_t colour_cont          colour control port value
+//         uint8_t colour               colour RAM value
+//         int *fgc                     foreground colour index returned
+//         int *bgc                     background colour index returned
+// return: void
+//==============================================================================
+void vdu_colour_pair (uint8_t colour_cont, uint8_t colour, int *fgc, int *bgc)
+{
+ if (modelx.colour == 0 || crtc.monitor)
+    {
+     // monochrome
+     *fgc = 2;
+     *bgc = 0;
+     if ((modelx.alphap) && (modelx.halfint))
+        {
+         if (colour & B8(00001000))
+            (*fgc)++;
+         if (colour & B8(10000000))
+            (*bgc)++;
+        }
+    }
+ else if (modelx.colour == MODCOL1)
+    {
+     // 56k colour board, an indexed surface takes the background intensity
+     // from the palette
+     *fgc = ic_82s23[colour & B8(00011111)];
+     if (video.indexed)
+        *bgc = VDU_PAL_BG + ((colour & B8(11100000)) >> 5);
+     else
+        *bgc = (bg_standard_colour[(colour_cont & B8(00001110)) >> 1] << 3)
+           | (bg_standard_colour[(colour & B8(11100000)) >> 5]);
+    }
+ else
+    {
+     // premium/teleterm/256tc
+     *fgc = (colour & 0x0F);
+     *bgc = (colour >> 4);
     }
- SDL_UnlockSurface(char_data);
 }
 
 //==============================================================================
@@ -1211,6 +2060,7 @@ void vdu_draw_char(SDL_Surface *screen, int x, int y,
  static SDL_Color inverse_colours[2];
  SDL_Color *cmap;
  SDL_Color *inv_cmap;           /* for the moment */
+ SDL_Color *pal;
  int sx, sy;                    /* source X and Y */
  int bank;
  uint8_t ch;
@@ -1223,11 +2073,11 @@ void vdu_draw_char(SDL_Surface *screen, int x, int y,
                                  * drawn. */
  int fgc, bgc;
 
- ch = vdu.scr_ram[maddr & vdu.scr_mask];
- attrib = vdu.extendram
-    ? vdu.att_ram[maddr & vdu.scr_mask]
+ ch = vdr->scr_ram[maddr & vdr->scr_mask];
+ attrib = vdr->extendram
+    ? vdr->att_ram[maddr & vdr->scr_mask]
     : 0;
- colour = vdu.col_ram[maddr & vdu.scr_mask];
+ colour = vdr->col_ram[maddr & vdr->scr_mask];
 
  if (ch & 0x80)
     {
@@ -1311,36 +2161,24 @@ void vdu_draw_char(SDL_Surface *screen, int x, int y,
   * Construct the inverse and normal colour maps from the global
   * colour map
   */
- if (modelx.colour == 0 || crtc.monitor)
+ vdu_colour_pair(vdr->colour_cont, colour, &fgc, &bgc);
+ if (vdu_glyph_draw(screen, x, y, bank, ch,
+                    inverse ? bgc : fgc, inverse ? fgc : bgc,
+                    lines, regionheights) == 0)
     {
-     // monochrome
-     fgc = 2;
-     bgc = 0;
-     if ((modelx.alphap) && (modelx.halfint))
-        {
-         if (colour & B8(00001000))
-            fgc++;
-         if (colour & B8(10000000))
-            bgc++;
-        }
-    }
- else if (modelx.colour == MODCOL1)
-    {
-     // 56k colour board
-     fgc = ic_82s23[colour & B8(00011111)];
-     bgc = (bg_standard_colour[(vdu.colour_cont & B8(00001110)) >> 1] << 3)
-        | (bg_standard_colour[(colour & B8(11100000)) >> 5]);
+     dstrect.x = x;
+     dstrect.y = y;
+     dstrect.w = 8;
+     dstrect.h = lines * video.yscale;
+     video_update_region(dstrect);
+     return;
     }
- else
-    {
-     // premium/teleterm/256tc
-     fgc = (colour & 0x0F);
-     bgc = (colour >> 4);
-    }
- colours[0] = col_table[bgc];
- colours[1] = col_table[fgc];
- inverse_colours[0] = col_table[fgc];
- inverse_colours[1] = col_table[bgc];
+
+ pal = video.indexed ? screen->format->palette->colors : col_table;
+ colours[0] = pal[bgc];
+ colours[1] = pal[fgc];
+ inverse_colours[0] = pal[fgc];
+ inverse_colours[1] = pal[bgc];
 
  cmap = inverse ? inverse_colours : colours;
  inv_cmap = inverse ? colours : inverse_colours;
@@ -1383,20 +2221,68 @@ void vdu_draw_char(SDL_Surface *screen, int x, int y,
 }       
 
 
+//==============================================================================
+// VDU set palette.
+//
+// The palette of an 8 bit indexed display surface holds the colour table,
+// the 56k colour board backgrounds for the current colour port intensity
+// bits and a 6x6x5 colour cube for the OSD colours.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void vdu_set_palette (void)
+{
+ SDL_Color pal[256];
+ int bg;
+ int i;
+
+ if (! video.indexed)
+    return;
+
+ memset(pal, 0, sizeof(pal));
+ for (i = 0; i < VDU_PAL_BG; i++)
+    pal[i] = col_table[i];
+
+ bg = bg_standard_colour[(vdu.colour_cont & B8(00001110)) >> 1] << 3;
+ for (i = 0; i < 8; i++)
+    pal[VDU_PAL_BG + i] = col_table[bg | bg_standard_colour[i]];
+
+ for (i = 0; i < 6 * 6 * 5; i++)
+    {
+     pal[VDU_PAL_CUBE + i].r = (i / 30) * 51;
+     pal[VDU_PAL_CUBE + i].g = ((i / 5) % 6) * 51;
+     pal[VDU_PAL_CUBE + i].b = (i % 5) * 255 / 4;
+    }
+
+ video_set_palette(pal, 256);
+}
+
 //==============================================================================
 // VDU set colour table
 // Updates the cached SDL pixel values for each possible colour for the current
 // screen surface.
 //
+// An indexed display surface only needs its palette set again, the display
+// only needs to be redrawn if the change is between monochrome and colour as
+// the colour indexes are then chosen differently.
+//
 //   pass: void
-// return: void
+// return: int                          1 if the display must be redrawn
 //==============================================================================
-void vdu_setcolourtable()
+int vdu_setcolourtable (void)
 {
+ static int last_mono = -1;
+ int mono;
  int i;
  const uint8_t (*coltable)[3];
 
- if (modelx.colour == 0 || crtc.monitor)
+ video_thread_sync();
+ if (! video.indexed)
+    vdu_glyph_cache_flush();
+
+ mono = (modelx.colour == 0 || crtc.monitor);
+ if (mono)
     {
      /* For monochrome models we use the first 4 entries in col_table.
         The entries are numbered like so:
@@ -1482,6 +2368,12 @@ void vdu_setcolourtable()
          col_table[i].b = coltable[i][2];
         }
     }
+
+ vdu_set_palette();
+
+ i = (! video.indexed) || (mono != last_mono);
+ last_mono = mono;
+ return i;
 }
 
 //==============================================================================
@@ -1508,6 +2400,8 @@ void vdu_set_mon_table (int pos, int col)
 //==============================================================================
 void vdu_configure (int aspect)
 {
+ video_thread_sync();
+ vdu_glyph_cache_flush();
  if (char_data)
     vdu_destroy_char_surface();
  vdu_create_char_surface();
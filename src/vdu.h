@@ -18,6 +18,23 @@
 #define ATT_RAM_SIZE 0x0800 * ATT_RAM_BANKS
 #define PCG_RAM_SIZE 0x0800 * PCG_RAM_BANKS
 
+// redraw flags are kept as a bitset with a summary bit for each word
+#define VDU_REDRAW_WORDS (SCR_RAM_SIZE / 64)
+#define VDU_REDRAW_SUMS ((VDU_REDRAW_WORDS + 63) / 64)
+
+// changed PCG glyphs are kept as a bitset
+#define VDU_PCG_GLYPHS (PCG_RAM_SIZE / 16)
+#define VDU_PCG_WORDS (VDU_PCG_GLYPHS / 64)
+
+// palette layout of an 8 bit indexed display surface, the colour table
+// entries are followed by the 56k colour board backgrounds and a colour cube
+// for the OSD
+#define VDU_PAL_BG 64
+#define VDU_PAL_CUBE (VDU_PAL_BG + 8)
+
+// character returned by vdu_text_char() for a PCG character that is not blank
+#define VDU_TEXT_PCG '#'
+
 // #defines for the hardware flashing circuit
 #define HFNO  0
 #define HFV3  1
@@ -123,10 +140,17 @@ void vdu_draw_char(SDL_Surface *screen, int x, int y,
                                         * flashing timer */
                    uint8_t cursor, uint8_t cur_start, uint8_t cur_end);
 void vdu_redraw_char(int addr);
-uint8_t vdu_char_is_redrawn(int addr);
-void vdu_char_clear_redraw(int addr);
-void vdu_propagate_pcg_updates(int maddr, int size);
+int vdu_text_char (int addr);
+void vdu_colour_pair (uint8_t colour_cont, uint8_t colour, int *fgc, int *bgc);
+int vdu_redraw_pending (void);
+uint64_t vdu_redraw_take (int maddr, int n);
+int vdu_redraw_next (int maddr);
+void vdu_propagate_pcg_updates (void);
+void vdu_pcg_index_rebuild (void);
 void vdu_propagate_flashing_attr(int maddr, int size);
+void vdu_snapshot_mode (int enable);
+uint8_t vdu_render_colour_cont (int colour_cont);
+void vdu_snapshot (void);
 
 void vdu_write_char_data(int bank, int offset, uint8_t *data, int numbytes);
 void vdu_write_pcg_data(int bank, int offset, uint8_t *data, int numbytes);
@@ -146,9 +170,21 @@ void vdu_lvdat_w (uint16_t port, uint8_t data, struct z80_port_write *port_s);
 void vdu_latchrom_w (uint16_t port, uint8_t data, struct z80_port_write *port_s);
 
 void vdu_set_mon_table (int pos, int col);
-void vdu_setcolourtable();
+int vdu_setcolourtable (void);
+void vdu_set_palette (void);
 void vdu_configure (int aspect);
+void vdu_glyph_cache_flush (void);
+void vdu_frame_diff (void);
 
+typedef struct vdu_glyph_t
+{
+ uint32_t key;               /* bank, character and colour pair */
+ uint16_t gen;               /* glyph generation when expanded */
+ int16_t hash;               /* hash bucket */
+ int16_t hnext;              /* next entry in the hash bucket */
+ int16_t prev;               /* LRU list links */
+ int16_t next;
+}vdu_glyph_t;
 
 typedef struct vdu_t
 {
@@ -173,7 +209,7 @@ typedef struct vdu_t
  /*
   * Used internally to track the character positions that need to be redrawn
   */
- uint8_t *redraw_ptr;        /* redraw RAM */
+ int redraw_ofs;             /* redraw bit of the selected screen bank */
  /*
   * The Alpha+/256TC video hardware supports up to 8k of
   * screen/attribute/colour RAM
@@ -188,8 +224,9 @@ typedef struct vdu_t
  uint8_t col_ram[COL_RAM_SIZE];
  uint8_t att_ram[ATT_RAM_SIZE];
  uint8_t pcg_ram[PCG_RAM_SIZE];  // last bank is a dummy bank
- uint8_t redraw[SCR_RAM_SIZE];
- uint8_t pcg_redraw[PCG_RAM_SIZE / 16]; /* FIXME: need a character height constant */
+ uint64_t redraw[VDU_REDRAW_WORDS];    /* 1 bit for each screen location */
+ uint64_t redraw_sum[VDU_REDRAW_SUMS]; /* 1 bit for each non zero word */
+ uint64_t pcg_redraw[VDU_PCG_WORDS];  /* 1 bit for each changed PCG glyph */
 }vdu_t;
 
 #endif /* HEADER_VDU_H */
@@ -31,6 +31,52 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - video_update() calls term_update() each frame for the text terminal.
+// - Added a software scaler for SDL rendering (--video-scale).  The display
+//   surface is then CRT sized and video_scale_present() scales its changed
+//   regions up to the window surface.
+// - Added an 8 bit indexed display surface (--video-depth=8i) where the
+//   pixels are colour table indexes, video_set_palette() sets the colours.
+// - Added video_draw_surface() to bring the display surface up to date for
+//   the capture module, video_update() calls capture_update() each frame.
+// - Video frames are passed to capture_record_frame() when the display
+//   surface is not being drawn on, as blank frames while the video is off.
+//   While iconified the surface is still drawn for a recording.
+// - OpenGL texture updates now upload each band of dirty scanlines on its
+//   own instead of everything between the first and last dirty scanline.
+//   The bands are staged through a pair of pixel buffer objects, persistently
+//   mapped if supported or orphaned each frame, so the upload overlaps the
+//   emulation of the next frame.  Upload statistics are reported on exit in
+//   verbose mode.
+// - Added the --gl-text OpenGL text display.  video_update() brings the
+//   shader textures up to date and presents a frame only if the display
+//   has changed, video_present() draws the display quad with the shader
+//   instead of uploading the display surface.
+// - video_init() calls expand_init() to select the character row expansion
+//   and frame difference compare functions for the host CPU.
+// - video_create_surface() flushes the VDU glyph cache as the cached pixels
+//   are in the format of the previous surface.
+// - Replaced the update region list with per scanline dirty spans.  The
+//   list was reallocated after every frame (leaking the old structure) and
+//   merged rectangles with a recursive O(n^2) scan.  The spans are sized
+//   when the surface is created, a new frame only increments a generation
+//   number and the rectangles for SDL_UpdateRects() are built in one pass.
+// - Added video_active_event() to track the window being iconified.  While
+//   iconified video_update() does no drawing, OSD animation or presenting
+//   and a full redraw is made when the window is restored.
+// - Added an optional render thread (--video-thread).  At each frame
+//   boundary video_update() publishes a snapshot of the CRTC and VDU state
+//   and the render thread draws it into the display surface while the Z80
+//   emulation carries on.  The frame is presented from the main thread at
+//   the next frame boundary as SDL 1.2 video calls (SDL_UpdateRects(), the
+//   GL texture upload and buffer swap) can't be made from another thread.
+// - Added video_thread_sync() to wait for the render thread to become idle,
+//   this must be called before the main thread touches the display surface.
+// - video_render() now syncs with the render thread, the presentation code
+//   is moved to video_present().
+// - video_deinit() is now called on exit.
+//
 // v6.0.0 - 1 January 2017, K Duckmanton
 // - Refactored this module to only redraw those parts of the screen that
 //   have been changed.
@@ -89,9 +135,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <assert.h>
 #include <SDL.h>
+#include <SDL_thread.h>
 
 #ifdef USE_OPENGL
 #include <SDL/SDL_opengl.h>
@@ -110,6 +158,11 @@
 #include "video.h"
 #include "crtc.h"
 #include "vdu.h"
+#include "expand.h"
+#include "scale.h"
+#include "gltext.h"
+#include "capture.h"
+#include "term.h"
 #include "mouse.h"
 #include "osd.h"
 
@@ -192,6 +245,7 @@
 video_t video =
 {
  .depth = VIDEO_16,             // default depth used by SDL only
+ .scale = 1,                    // software scale factor used by SDL only
  .type = VIDEO_SDLHW,           // default video rendering mode
 #ifdef USE_OPENGL
  .filter_fs = VIDEO_SHARP,
@@ -219,41 +273,72 @@ static RGB_Size rgb_sizes[3] = {
  { 8, 8, 8, 0 },                /* 24 bpp */
 };
 
+// Pixel buffer object functions, obtained at run time as the SDL 1.2
+// OpenGL header may not declare them.
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+
+static void (APIENTRY *p_glGenBuffers)(GLsizei n, GLuint *buffers);
+static void (APIENTRY *p_glDeleteBuffers)(GLsizei n, const GLuint *buffers);
+static void (APIENTRY *p_glBindBuffer)(GLenum target, GLuint buffer);
+static void (APIENTRY *p_glBufferData)(GLenum target, ptrdiff_t size,
+                                       const void *data, GLenum usage);
+static void *(APIENTRY *p_glMapBuffer)(GLenum target, GLenum access);
+static GLboolean (APIENTRY *p_glUnmapBuffer)(GLenum target);
+static void (APIENTRY *p_glBufferStorage)(GLenum target, ptrdiff_t size,
+                                          const void *data, GLbitfield flags);
+static void *(APIENTRY *p_glMapBufferRange)(GLenum target, ptrdiff_t offset,
+                                            ptrdiff_t length, GLbitfield access);
+static void *(APIENTRY *p_glFenceSync)(GLenum condition, GLbitfield flags);
+static GLenum (APIENTRY *p_glClientWaitSync)(void *sync, GLbitfield flags,
+                                             uint64_t timeout);
+static void (APIENTRY *p_glDeleteSync)(void *sync);
+
+extern gltext_t gltext;
 #endif
 
 SDL_Surface *screen;
+
+// The window surface when the software scaler is used, 'screen' is then a
+// surface of the CRT size that is scaled up to it when presented.
+static SDL_Surface *scale_screen;
+static uint32_t scale_dark;
+static video_thread_t video_thread;
 static SDL_VideoInfo video_info;
 static SDL_Color colors[256];
 video_putpixel_fast_fn video_putpixel_fast_p;
 
 extern emu_t emu;
 extern crtc_t crtc;
+extern capture_t capture;
 extern gui_t gui;
 extern gui_status_t gui_status;
 extern modio_t modio;
 extern mouse_t mouse;
 
-
-struct _dynamic_array {
-   void *p;                     /* pointer to the array of things */
-   int entrysize;               /* size of each entry */
-   int numentries;              /* number of active entries in the
-                                 * array  */
-   int size;                    /* current size of the array */
-};
-
-struct video_update_regions {
-   union {
-      struct _dynamic_array a;
-      SDL_Rect *p;
-   } rects;
-   union {
-      struct _dynamic_array a;
-      SDL_Rect **p;
-   } free_rects;
-};
-
-struct video_update_regions *video_update_regions;
+static video_dirty_t video_dirty;
 
 
 #ifdef USE_OPENGL
@@ -267,13 +352,21 @@ static void video_gl_probe_preferred_texture_format (void);
 #endif
 
 static void video_update_sdl_video_flags();
+static void video_present (void);
+static void video_scale_present (void);
+static void video_palette (SDL_Color *colours, int n);
+static int video_thread_start (void);
+static void video_thread_stop (void);
+static void video_thread_frame (void);
 
 void video_putpixel_fast_8bpp(int x, int y, int val);
 void video_putpixel_fast_16bpp(int x, int y, int val);
 void video_putpixel_fast_32bpp(int x, int y, int val);
 
-void video_free_update_regions();
-void video_init_update_regions();
+static int video_dirty_configure (int lines);
+static void video_dirty_free (void);
+static void video_dirty_reset (void);
+static void video_dirty_rects (void);
 
 
 
@@ -296,6 +389,16 @@ int video_init (void)
  int crt_h;
  int i;
 
+ expand_init();
+ scale_init();
+ if (emu.verbose)
+    {
+     xprintf("video: %s character row expansion\n", expand_name());
+     if (video.diff)
+        xprintf("video: %s frame difference compare\n", expand_name());
+     xprintf("video: %s software scaler\n", scale_name());
+    }
+
  video_info = *SDL_GetVideoInfo();
  video.desktop_w = video_info.current_w;
  video.desktop_h = video_info.current_h;
@@ -374,13 +477,18 @@ int video_init (void)
      xprintf("video_init: Unable to create the application window\n");
      return -1;
     }
- video_init_update_regions();
  if (video_create_surface(crt_w, crt_h * video.yscale) == -1)
     {
      xprintf("video_init: Unable to create the display surface\n");
      return -1;
     }
 
+ if (video.thread && video_thread_start() == -1)
+    {
+     xprintf("video_init: Unable to create the render thread\n");
+     return -1;
+    }
+
  return 0;
 }
 
@@ -392,7 +500,16 @@ int video_init (void)
 //==============================================================================
 int video_deinit (void)
 {
- video_free_update_regions();
+ video_thread_stop();
+ video_dirty_free();
+#ifdef USE_OPENGL
+ gltext_destroy();
+ if (emu.verbose && video_gl.upload_frames)
+    xprintf("video: OpenGL uploads %d frames, %d bytes average, %d bytes"
+            " maximum per frame\n", video_gl.upload_frames,
+            (int)(video_gl.upload_bytes / video_gl.upload_frames),
+            video_gl.upload_max);
+#endif
  return 0;
 }
 
@@ -441,8 +558,8 @@ void video_convert_mouse_to_crtc_xy (int mouse_x, int mouse_y, int *x, int *y)
  else
 #endif
     {
-     *x = mouse_x;
-     *y = mouse_y / video.yscale;
+     *x = mouse_x / video.scale;
+     *y = mouse_y / (video.yscale * video.scale);
     }
 }
 
@@ -468,8 +585,8 @@ void video_convert_crtc_to_mouse_xy (int crtc_x, int crtc_y, int *x, int *y)
  else
 #endif
     {
-     *x = crtc_x;
-     *y = crtc_y * video.yscale;
+     *x = crtc_x * video.scale;
+     *y = crtc_y * video.yscale * video.scale;
     }
 }
 
@@ -1145,6 +1262,292 @@ static void video_gl_probe_preferred_texture_format (void)
 }
 
 
+#ifdef USE_OPENGL
+//==============================================================================
+// Display surface texture uploads.
+//
+// The dirty scanlines are grouped into bands, scanlines separated by no more
+// than VIDEO_GL_BAND_GAP clean scanlines being joined, and each band is
+// uploaded as its own rectangle.  A change at the top and bottom of the
+// display does not upload everything in between.
+//
+// When pixel buffer objects are available the bands are packed into one of
+// a pair of buffers, used on alternate frames, and the texture is updated
+// from the buffer.  glTexSubImage2D() then returns straight away and the
+// copy to the texture is carried out by the driver while the next frame is
+// emulated.  Persistently mapped buffers with a fence for each are used if
+// supported, otherwise the buffer is orphaned and mapped each frame.
+//==============================================================================
+
+//==============================================================================
+// Delete the pixel buffers.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void video_gl_pbo_destroy (void)
+{
+ int i;
+
+ for (i = 0; i < 2; i++)
+    {
+     if (video_gl.pbo_fence[i])
+        p_glDeleteSync(video_gl.pbo_fence[i]);
+     video_gl.pbo_fence[i] = NULL;
+     video_gl.pbo_map[i] = NULL;
+    }
+ if (video_gl.pbo[0])
+    p_glDeleteBuffers(2, video_gl.pbo);
+ video_gl.pbo[0] = video_gl.pbo[1] = 0;
+ video_gl.upload = VIDEO_GL_UPLOAD_DIRECT;
+}
+
+//==============================================================================
+// Create the pixel buffers used to upload the display surface.  Called each
+// time the display texture is created.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void video_gl_pbo_create (void)
+{
+ const char *ext = (const char *)glGetString(GL_EXTENSIONS);
+ const char *version = (const char *)glGetString(GL_VERSION);
+ int major = 0;
+ int minor = 0;
+ int glver;
+ int persist;
+ int i;
+
+ video_gl_pbo_destroy();
+
+ if (version)
+    sscanf(version, "%d.%d", &major, &minor);
+ glver = major * 100 + minor;
+ if (! ext)
+    ext = "";
+
+ if ((glver < 201) && (! strstr(ext, "GL_ARB_pixel_buffer_object")))
+    return;
+
+ p_glGenBuffers = SDL_GL_GetProcAddress("glGenBuffers");
+ p_glDeleteBuffers = SDL_GL_GetProcAddress("glDeleteBuffers");
+ p_glBindBuffer = SDL_GL_GetProcAddress("glBindBuffer");
+ p_glBufferData = SDL_GL_GetProcAddress("glBufferData");
+ p_glMapBuffer = SDL_GL_GetProcAddress("glMapBuffer");
+ p_glUnmapBuffer = SDL_GL_GetProcAddress("glUnmapBuffer");
+ if ((! p_glGenBuffers) || (! p_glDeleteBuffers) || (! p_glBindBuffer) ||
+    (! p_glBufferData) || (! p_glMapBuffer) || (! p_glUnmapBuffer))
+    return;
+
+ persist = ((glver >= 404) || strstr(ext, "GL_ARB_buffer_storage")) &&
+           ((glver >= 302) || strstr(ext, "GL_ARB_sync"));
+ if (persist)
+    {
+     p_glBufferStorage = SDL_GL_GetProcAddress("glBufferStorage");
+     p_glMapBufferRange = SDL_GL_GetProcAddress("glMapBufferRange");
+     p_glFenceSync = SDL_GL_GetProcAddress("glFenceSync");
+     p_glClientWaitSync = SDL_GL_GetProcAddress("glClientWaitSync");
+     p_glDeleteSync = SDL_GL_GetProcAddress("glDeleteSync");
+     persist = p_glBufferStorage && p_glMapBufferRange && p_glFenceSync &&
+               p_glClientWaitSync && p_glDeleteSync;
+    }
+
+ glCLEARERROR();
+ video_gl.pbo_size = screen->pitch * screen->h;
+ video_gl.pbo_next = 0;
+ p_glGenBuffers(2, video_gl.pbo);
+
+ for (i = 0; i < 2; i++)
+    {
+     p_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, video_gl.pbo[i]);
+     if (persist)
+        {
+         p_glBufferStorage(GL_PIXEL_UNPACK_BUFFER, video_gl.pbo_size, NULL,
+                           GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                           GL_MAP_COHERENT_BIT);
+         video_gl.pbo_map[i] =
+            p_glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, video_gl.pbo_size,
+                               GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                               GL_MAP_COHERENT_BIT);
+         if (! video_gl.pbo_map[i])
+            break;
+        }
+     else
+        p_glBufferData(GL_PIXEL_UNPACK_BUFFER, video_gl.pbo_size, NULL,
+                       GL_STREAM_DRAW);
+    }
+ p_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+ if ((i < 2) || (glGetError() != GL_NO_ERROR))
+    {
+     video_gl_pbo_destroy();
+     glCLEARERROR();
+     return;
+    }
+
+ video_gl.upload = persist ? VIDEO_GL_UPLOAD_PERSIST : VIDEO_GL_UPLOAD_ORPHAN;
+}
+
+//==============================================================================
+// Group the dirty scanlines into bands.  The rectangles are placed in the
+// update region rectangle list.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void video_gl_bands (void)
+{
+ int y;
+ int x2;
+ int gap = 0;
+ video_span_t *sp;
+ SDL_Rect *rp = NULL;
+
+ video_dirty.nrects = 0;
+
+ for (y = video_dirty.miny; y < video_dirty.maxy; y++)
+    {
+     sp = &video_dirty.span[y];
+     if (sp->gen != video_dirty.gen)
+        {
+         gap++;
+         continue;
+        }
+     if (rp && (gap <= VIDEO_GL_BAND_GAP))
+        {
+         x2 = rp->x + rp->w;
+         if (sp->x1 < rp->x)
+            rp->x = sp->x1;
+         if (sp->x2 > x2)
+            x2 = sp->x2;
+         rp->w = x2 - rp->x;
+         rp->h = y - rp->y + 1;
+        }
+     else
+        {
+         rp = &video_dirty.rects[video_dirty.nrects++];
+         rp->x = sp->x1;
+         rp->y = y;
+         rp->w = sp->x2 - sp->x1;
+         rp->h = 1;
+        }
+     gap = 0;
+    }
+}
+
+//==============================================================================
+// Upload the dirty bands of the display surface to the texture.  The
+// texture must be bound.
+//
+//   pass: void
+// return: int                          number of bytes uploaded
+//==============================================================================
+static int video_gl_upload (void)
+{
+ int bpp = screen->format->BytesPerPixel;
+ int pbo = 0;
+ uint8_t *dst = NULL;
+ uint8_t *src;
+ SDL_Rect *rp;
+ int ofs;
+ int n;
+ int i, y;
+
+ video_gl_bands();
+ if (! video_dirty.nrects)
+    return 0;
+
+ if (video_gl.upload != VIDEO_GL_UPLOAD_DIRECT)
+    {
+     pbo = video_gl.pbo_next;
+     video_gl.pbo_next ^= 1;
+     p_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, video_gl.pbo[pbo]);
+     if (video_gl.upload == VIDEO_GL_UPLOAD_PERSIST)
+        {
+         // wait for the driver to finish with the last use of this buffer
+         if (video_gl.pbo_fence[pbo])
+            {
+             p_glClientWaitSync(video_gl.pbo_fence[pbo],
+                                GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+             p_glDeleteSync(video_gl.pbo_fence[pbo]);
+             video_gl.pbo_fence[pbo] = NULL;
+            }
+         dst = video_gl.pbo_map[pbo];
+        }
+     else
+        {
+         // orphan the old storage so there's no wait for the driver
+         p_glBufferData(GL_PIXEL_UNPACK_BUFFER, video_gl.pbo_size, NULL,
+                        GL_STREAM_DRAW);
+         dst = p_glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+        }
+     if (! dst)
+        {
+         p_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+         video_gl.upload = VIDEO_GL_UPLOAD_DIRECT;
+        }
+    }
+
+ glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+ // pack the bands into the pixel buffer
+ if (dst)
+    {
+     for (i = 0, ofs = 0; i < video_dirty.nrects; i++)
+        {
+         rp = &video_dirty.rects[i];
+         n = rp->w * bpp;
+         src = (uint8_t *)screen->pixels + rp->y * screen->pitch + rp->x * bpp;
+         for (y = 0; y < rp->h; y++, src += screen->pitch, ofs += n)
+            memcpy(dst + ofs, src, n);
+        }
+     if (video_gl.upload == VIDEO_GL_UPLOAD_ORPHAN)
+        p_glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+ else
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, screen->pitch / bpp);
+
+ for (i = 0, ofs = 0; i < video_dirty.nrects; i++)
+    {
+     rp = &video_dirty.rects[i];
+     if (dst)
+        src = (uint8_t *)(intptr_t)ofs;
+     else
+        src = (uint8_t *)screen->pixels + rp->y * screen->pitch + rp->x * bpp;
+     glTexSubImage2D(GL_TEXTURE_2D, 0, rp->x, rp->y, rp->w, rp->h,
+                     video_gl.pixel_format, video_gl.pixel_type, src);
+     ofs += rp->w * rp->h * bpp;
+    }
+
+ if (dst)
+    {
+     if (video_gl.upload == VIDEO_GL_UPLOAD_PERSIST)
+        video_gl.pbo_fence[pbo] = p_glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+     p_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+ else
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+ glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+ return ofs;
+}
+
+//==============================================================================
+// Add a frame to the texture upload statistics.
+//
+//   pass: int bytes                    bytes uploaded for the frame
+// return: void
+//==============================================================================
+static void video_gl_upload_stats (int bytes)
+{
+ video_gl.upload_frames++;
+ video_gl.upload_bytes += bytes;
+ if (bytes > video_gl.upload_max)
+    video_gl.upload_max = bytes;
+}
+#endif
+
 //==============================================================================
 // Create an OpenGL texture.
 //
@@ -1205,6 +1608,9 @@ static void video_gl_create_texture (void)
 
  glFlush();
  glCLEARERROR();
+
+ video_gl_pbo_create();
+ gltext_create();
 }
 
 //==============================================================================
@@ -1282,11 +1688,71 @@ void video_update_sdl_video_flags(void)
     }
 }
 
+//==============================================================================
+// Set the SDL video mode.
+//
+// When the software scaler is used (--video-scale) the window is made
+// larger by the scale factor and a surface of the CRT size in the same
+// format is returned to draw on, it's scaled up to the window as it's
+// presented.  The window is then always a software surface as only the
+// changed regions are scaled and updated.
+//
+//   pass: int crt_w            CRT display width
+//         int crt_h            CRT display height
+//         int bpp              bits per pixel
+//         int flags            SDL video flags
+// return: SDL_Surface *        surface to draw on, NULL if error
+//==============================================================================
+static SDL_Surface *video_set_mode (int crt_w, int crt_h, int bpp, int flags)
+{
+ SDL_Surface *s;
+ SDL_PixelFormat *f;
+ uint32_t dark;
+
+ if (video.scale < 2)
+    return SDL_SetVideoMode(crt_w, crt_h, bpp, flags);
+
+ flags &= ~(SDL_HWSURFACE | SDL_DOUBLEBUF);
+ s = SDL_SetVideoMode(crt_w * video.scale, crt_h * video.scale, bpp,
+                      flags | SDL_SWSURFACE);
+ if (s == NULL)
+    return NULL;
+
+ f = s->format;
+ screen = SDL_CreateRGBSurface(SDL_SWSURFACE, crt_w, crt_h, f->BitsPerPixel,
+                               f->Rmask, f->Gmask, f->Bmask, f->Amask);
+ if (screen == NULL)
+    return NULL;
+ if (f->palette)
+    SDL_SetPalette(screen, SDL_LOGPAL, f->palette->colors, 0,
+                   f->palette->ncolors);
+ scale_screen = s;
+
+ // half brightness mask for the scan lines, not possible with a palette
+ dark = ((f->Rmask >> 1) & f->Rmask) | ((f->Gmask >> 1) & f->Gmask) |
+        ((f->Bmask >> 1) & f->Bmask);
+ if (f->BytesPerPixel == 2)
+    dark |= dark << 16;
+ scale_dark = (video.scanlines && (f->BytesPerPixel > 1)) ? dark : 0;
+
+ return screen;
+}
+
 int video_create_surface (int crt_w, int crt_h)
 {
  int i;
 
+ video_thread_sync();
  video_update_sdl_video_flags();
+ video.indexed = 0;
+
+ // the CRT sized surface of the software scaler is not kept
+ if (scale_screen)
+    {
+     SDL_FreeSurface(screen);
+     screen = NULL;
+     scale_screen = NULL;
+    }
 
  if (video.fullscreen)
     SDL_ShowCursor(SDL_DISABLE); // don't show the mouse cursor
@@ -1304,11 +1770,11 @@ int video_create_surface (int crt_w, int crt_h)
            {
             case VIDEO_8 :
                video.bpp = 8;
-               screen = SDL_SetVideoMode(crt_w, crt_h, 8, video.flags);
+               screen = video_set_mode(crt_w, crt_h, 8, video.flags);
                break;
             case VIDEO_8GS :
                video.bpp = 8;
-               screen = SDL_SetVideoMode(crt_w, crt_h, 8, video.flags);
+               screen = video_set_mode(crt_w, crt_h, 8, video.flags);
                if (screen)
                   {
                    for (i = 0; i < 256; i++) // create a grey scale
@@ -1317,17 +1783,26 @@ int video_create_surface (int crt_w, int crt_h)
                        colors[i].g = i;
                        colors[i].b = i;
                       }
-                   SDL_SetColors(screen, colors, 0, 256);
-                   SDL_SetPalette(screen, SDL_LOGPAL|SDL_PHYSPAL, colors, 0, 256);
+                   video_palette(colors, 256);
+                  }
+               break;
+            case VIDEO_8I :
+               video.bpp = 8;
+               screen = video_set_mode(crt_w, crt_h, 8,
+                                       video.flags | SDL_HWPALETTE);
+               if (screen)
+                  {
+                   video.indexed = 1;
+                   vdu_set_palette();
                   }
                break;
             case VIDEO_16 :
                video.bpp = 16;
-               screen = SDL_SetVideoMode(crt_w, crt_h, 16, video.flags);
+               screen = video_set_mode(crt_w, crt_h, 16, video.flags);
                break;
             case VIDEO_32 :
                video.bpp = 32;
-               screen = SDL_SetVideoMode(crt_w, crt_h, 32, video.flags);
+               screen = video_set_mode(crt_w, crt_h, 32, video.flags);
                break;
            }
         if (screen == NULL)
@@ -1378,8 +1853,10 @@ int video_create_surface (int crt_w, int crt_h)
 #endif
     }
 
- video_free_update_regions();
- video_init_update_regions();
+ if (video_dirty_configure(screen->h) == -1)
+    return -1;
+
+ vdu_glyph_cache_flush();
 
  video_report_information();
 
@@ -1389,6 +1866,21 @@ int video_create_surface (int crt_w, int crt_h)
 //==============================================================================
 // Video renderer.
 //
+// Waits for the render thread (if any) to become idle then presents the
+// display surface.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void video_render (void)
+{
+ video_thread_sync();
+ video_present();
+}
+
+//==============================================================================
+// Present the display surface.
+//
 // video type   rendering method
 // ----------   ----------------
 //     0        SDL Software rendering
@@ -1398,16 +1890,20 @@ int video_create_surface (int crt_w, int crt_h)
 //   pass: void
 // return: void
 //==============================================================================
-void video_render (void)
+static void video_present (void)
 {
 
 #ifdef USE_OPENGL
  if (video.type == VIDEO_GL)
     {
      GLenum glerror = 0;
+     int shader = gltext_active();
 
      glCLEARERROR();
-     glBindTexture(GL_TEXTURE_2D, video_gl.texture);
+     if (shader)
+        gltext_bind(video_gl.texture_w, video_gl.texture_h);
+     else
+        glBindTexture(GL_TEXTURE_2D, video_gl.texture);
      glerror = glGetError();
      if (glerror != GL_NO_ERROR)
         {
@@ -1420,44 +1916,14 @@ void video_render (void)
                  glerror);
          glCLEARERROR();
         }
-     /*
-      * Textures which are in use can't be updated until the video
-      * card has finished rendering a frame, so the number of calls to
-      * glTexSubImage2D() should be minimised.
-      *
-      * glTexSubImage2D() expects the pixels comprising the region to
-      * be contiguous.
-      *
-      * Compute the vertical extent of the texture regions updated
-      */
-     {
-      int i;
-      Sint16 miny = 0, maxy = 0;
-      SDL_Rect *rp;
-      void *pixptr;
-      for (i = 0, rp = video_update_regions->rects.p;
-           i < video_update_regions->rects.a.numentries;
-           ++i, ++rp)
-         {
-          if (rp->w == 0 || rp->h == 0)
-             continue;
-          if (rp->y < miny)
-             miny = rp->y;
-          if (rp->y + rp->h > maxy)
-             maxy = rp->y + rp->h;
-         }
-      if (maxy - miny > 0)
-         {
-          pixptr = 
-             screen->pixels
-             + miny * screen->pitch;
-          glTexSubImage2D(GL_TEXTURE_2D, 0, 
-                          0, miny, screen->w, maxy - miny,
-                          video_gl.pixel_format, video_gl.pixel_type,
-                          pixptr);
-          glerror = glGetError();
-         }
-     }
+     // update the texture with the dirty bands of the display surface
+     if (shader)
+        video_gl_upload_stats(gltext.uploads);
+     else
+        {
+         video_gl_upload_stats(video_gl_upload());
+         glerror = glGetError();
+        }
 #endif
      if (glerror != GL_NO_ERROR)
         {
@@ -1494,19 +1960,22 @@ void video_render (void)
                         video_gl.texture_region.y + video_gl.texture_region.h);
              glEnd();
             }
+         if (shader)
+            gltext_unbind();
          glCLEARERROR();
          SDL_GL_SwapBuffers();
         }
     }
  else
-    if (video.type == VIDEO_SDLSW ||
+    if (scale_screen)
+       video_scale_present();
+    else if (video.type == VIDEO_SDLSW ||
         (screen->flags & SDL_DOUBLEBUF) != SDL_DOUBLEBUF)
        {
         // SDL software rendering, or rendering to a screen that isn't
         // double buffered
-        SDL_UpdateRects(screen, 
-                        video_update_regions->rects.a.numentries,
-                        video_update_regions->rects.p);
+        video_dirty_rects();
+        SDL_UpdateRects(screen, video_dirty.nrects, video_dirty.rects);
        }
     else if (video.type == VIDEO_SDLHW)
        {
@@ -1517,8 +1986,62 @@ void video_render (void)
        {
         // default, which shouldn't happen!
        }
- video_free_update_regions();
- video_init_update_regions();
+ video_dirty_reset();
+}
+
+//==============================================================================
+// Present the display surface with the software scaler.
+//
+// Only the changed regions of the display surface are scaled to the window
+// surface and updated.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void video_scale_present (void)
+{
+ SDL_Rect r;
+ int bpp = screen->format->BytesPerPixel;
+ int f = video.scale;
+ int x1;
+ int x2;
+ int i;
+ int n = 0;
+
+ video_dirty_rects();
+
+ if (SDL_MUSTLOCK(scale_screen) && (SDL_LockSurface(scale_screen) < 0))
+    return;
+
+ for (i = 0; i < video_dirty.nrects; i++)
+    {
+     r = video_dirty.rects[i];
+
+     // the spans are not clipped horizontally when they're added
+     x1 = (r.x < 0) ? 0 : r.x;
+     x2 = r.x + r.w;
+     if (x2 > screen->w)
+        x2 = screen->w;
+     if (x1 >= x2)
+        continue;
+
+     scale_block((uint8_t *)scale_screen->pixels + r.y * f * scale_screen->pitch
+                 + x1 * f * bpp, scale_screen->pitch,
+                 (uint8_t *)screen->pixels + r.y * screen->pitch + x1 * bpp,
+                 screen->pitch, x2 - x1, r.h, bpp, f, scale_dark);
+
+     // the rectangle becomes the scaled one to be updated
+     video_dirty.rects[n].x = x1 * f;
+     video_dirty.rects[n].y = r.y * f;
+     video_dirty.rects[n].w = (x2 - x1) * f;
+     video_dirty.rects[n].h = r.h * f;
+     n++;
+    }
+
+ if (SDL_MUSTLOCK(scale_screen))
+    SDL_UnlockSurface(scale_screen);
+
+ SDL_UpdateRects(scale_screen, n, video_dirty.rects);
 }
 
 #ifdef USE_OPENGL
@@ -1533,6 +2056,7 @@ void video_render (void)
 //==============================================================================
 int video_gl_create_surface (int crt_w, int crt_h, int win_w, int win_h)
 {
+ video_thread_sync();
  video_gl_window_resize(crt_w, crt_h, win_w, win_h);
 
  crtc_set_redraw();
@@ -1915,6 +2439,232 @@ int video_toggledisplay (void)
  return 0;
 }
 
+//==============================================================================
+// Render thread.
+//
+// Waits for a frame to be published by video_thread_frame() then draws it
+// into the display surface.  SDL 1.2 video calls must be made on the main
+// thread so the surface is presented there, the render thread only reports
+// if anything was drawn.
+//
+//   pass: void *data
+// return: int                  0
+//==============================================================================
+static int video_thread_worker (void *data)
+{
+ int drawn;
+
+ SDL_LockMutex(video_thread.mutex);
+ while (! video_thread.terminate)
+    {
+     if (! video_thread.pending)
+        {
+         SDL_CondWait(video_thread.work, video_thread.mutex);
+         continue;
+        }
+     video_thread.pending = 0;
+     video_thread.busy = 1;
+     SDL_UnlockMutex(video_thread.mutex);
+
+     drawn = crtc_render();
+
+     SDL_LockMutex(video_thread.mutex);
+     video_thread.drawn |= drawn;
+     video_thread.busy = 0;
+     SDL_CondBroadcast(video_thread.idle);
+    }
+ SDL_UnlockMutex(video_thread.mutex);
+
+ return 0;
+}
+
+//==============================================================================
+// Start the render thread.  From here on the character drawing functions
+// work from a snapshot of the VDU state.
+//
+//   pass: void
+// return: int                  0 if no error, -1 if error
+//==============================================================================
+static int video_thread_start (void)
+{
+ video_thread.pending = 0;
+ video_thread.busy = 0;
+ video_thread.drawn = 0;
+ video_thread.terminate = 0;
+ video_thread.mutex = SDL_CreateMutex();
+ video_thread.work = SDL_CreateCond();
+ video_thread.idle = SDL_CreateCond();
+ if (! video_thread.mutex || ! video_thread.work || ! video_thread.idle)
+    return -1;
+
+ vdu_snapshot_mode(1);
+ video_thread.thread = SDL_CreateThread(video_thread_worker, NULL);
+ if (! video_thread.thread)
+    {
+     vdu_snapshot_mode(0);
+     return -1;
+    }
+
+ return 0;
+}
+
+//==============================================================================
+// Stop the render thread.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void video_thread_stop (void)
+{
+ int status;
+
+ if (video_thread.thread)
+    {
+     SDL_LockMutex(video_thread.mutex);
+     video_thread.terminate = 1;
+     SDL_CondSignal(video_thread.work);
+     SDL_UnlockMutex(video_thread.mutex);
+     SDL_WaitThread(video_thread.thread, &status);
+     video_thread.thread = NULL;
+     vdu_snapshot_mode(0);
+    }
+ if (video_thread.idle)
+    SDL_DestroyCond(video_thread.idle);
+ if (video_thread.work)
+    SDL_DestroyCond(video_thread.work);
+ if (video_thread.mutex)
+    SDL_DestroyMutex(video_thread.mutex);
+ video_thread.idle = NULL;
+ video_thread.work = NULL;
+ video_thread.mutex = NULL;
+}
+
+//==============================================================================
+// Determine if the render thread is running.
+//
+//   pass: void
+// return: int                  1 if running, else 0
+//==============================================================================
+int video_thread_running (void)
+{
+ return video_thread.thread != NULL;
+}
+
+//==============================================================================
+// Wait for the render thread to finish any frame published to it.  This must
+// be called before the main thread draws into or changes the display
+// surface or the character surface.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void video_thread_sync (void)
+{
+ if (! video_thread.thread)
+    return;
+
+ SDL_LockMutex(video_thread.mutex);
+ while (video_thread.pending || video_thread.busy)
+    SDL_CondWait(video_thread.idle, video_thread.mutex);
+ SDL_UnlockMutex(video_thread.mutex);
+}
+
+//==============================================================================
+// Bring the display surface up to date with the current CRTC state so that
+// it can be read back.  The surface is not drawn while the display is hidden
+// (unless video is being recorded), the video is turned off or the text
+// display is drawn by a shader so a full redraw is made in those cases.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void video_draw_surface (void)
+{
+ int stale;
+
+ stale = (video.hidden && (! capture.recording)) || (! crtc.video);
+#ifdef USE_OPENGL
+ stale |= gltext.used;
+#endif
+
+ video_thread_sync();
+ if (stale)
+    crtc_set_redraw();
+ crtc_snapshot();
+ if (crtc_render())
+    crtc.update = 1;
+}
+
+//==============================================================================
+// Publish a frame to the render thread.
+//
+// If the render thread is still drawing the previous frame nothing is done,
+// the redraw flags keep accumulating and are picked up at the next frame
+// boundary.  Otherwise the frame drawn by the render thread is presented
+// here before the next one is published.  The render thread is idle while
+// the mutex is held so the surface and crtc.update are only touched by the
+// main thread.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void video_thread_frame (void)
+{
+ SDL_LockMutex(video_thread.mutex);
+ if (video_thread.pending || video_thread.busy)
+    {
+     SDL_UnlockMutex(video_thread.mutex);
+     capture_record_frame(CAPTURE_FRAME_REPEAT);
+     return;
+    }
+
+ // the last frame published is on the surface, none is while video is off
+ capture_record_frame(crtc.video ? CAPTURE_FRAME_NEW : CAPTURE_FRAME_BLANK);
+
+ if (video_thread.drawn)
+    crtc.update = 1;
+ video_thread.drawn = 0;
+ if (crtc.update)
+    {
+     video_present();
+     crtc.update = 0;
+    }
+
+ if (crtc.video)
+    {
+     crtc_snapshot();
+     video_thread.pending = 1;
+     SDL_CondSignal(video_thread.work);
+    }
+ SDL_UnlockMutex(video_thread.mutex);
+}
+
+//==============================================================================
+// Application activation event.
+//
+// SDL 1.2 reports the window being iconified and restored with the
+// SDL_APPACTIVE state.  The whole display is redrawn on restore.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void video_active_event (void)
+{
+ if (! (emu.event.active.state & SDL_APPACTIVE))
+    return;
+
+ if (emu.event.active.gain)
+    {
+     if (! video.hidden)
+        return;
+     video.hidden = 0;
+     crtc_set_redraw();
+     crtc.update = 1;
+    }
+ else
+    video.hidden = 1;
+}
+
 //==============================================================================
 // Video update. This is called after each Z80 code frame has completed.
 //
@@ -1926,15 +2676,53 @@ int video_toggledisplay (void)
 //==============================================================================
 void video_update (void)
 {
- osd_update();          // sets the crtc.update flag if OSD needs refreshing
+ capture_update();
+ term_update();
 
- crtc_redraw();         // only redraws if corresponding flag is set.
+ // nothing is presented while the window is iconified, the surface is only
+ // drawn if video is being recorded otherwise the redraw flags keep
+ // accumulating until it's restored
+ if (video.hidden)
+    {
+     if (capture.recording && crtc.video)
+        {
+         video_draw_surface();
+         capture_record_frame(CAPTURE_FRAME_NEW);
+        }
+     else
+        capture_record_frame(CAPTURE_FRAME_BLANK);
+     return;
+    }
+
+ osd_update();          // sets the crtc.update flag if OSD needs refreshing
 
 #ifdef USE_OPENGL
 // re-enable resize events after changing window size manually.
  ignore_one_resize_event = 0;
+
+ // the shader draws from the live video memory, no CPU drawing is needed
+ if (gltext_active())
+    {
+     video_thread_sync();
+     if (gltext_update() || crtc.update)
+        {
+         video_present();
+         crtc.update = 0;
+        }
+     return;
+    }
 #endif
 
+ // the OSD draws over the display on this thread so is always synchronous
+ if (video_thread_running() && emu.display_context == EMU_EMU_CONTEXT)
+    {
+     video_thread_frame();
+     return;
+    }
+
+ crtc_redraw();         // only redraws if corresponding flag is set.
+ capture_record_frame(crtc.video ? CAPTURE_FRAME_NEW : CAPTURE_FRAME_BLANK);
+
  if (crtc.update)
     {
      if (emu.display_context == EMU_OSD_CONTEXT)
@@ -1997,148 +2785,208 @@ void video_command (int cmd, int p)
     }
 }
 
-/* ==============================================================================
- *
- * Update region management
- *
- * Rectangular regions to update are stored as an array of SDL_Rects.
- *
- * Regions added to the set of regions are coalesced where possible.
- * Two regions are coalesced when
- * a) they are vertically adjacent and their widths are equal
- * b) they are horizontally adjacent and their heights are equal
- *
- */
+//==============================================================================
+// Update region management.
+//
+// Each scanline of the display surface holds the horizontal span of pixels
+// that have been drawn on it in the current frame.  A span belongs to the
+// current frame only if its generation number matches, so starting a new
+// frame is just an increment of the generation.  The dirty scanline range
+// bounds the scan made when the spans are turned into rectangles, adjacent
+// scanlines with the same span are joined into one rectangle.
+//
+// The span and rectangle arrays are sized for the display surface when it's
+// created and are not reallocated while drawing.
+//==============================================================================
 
-int video_resize_array(struct _dynamic_array *ap, int size)
+//==============================================================================
+// Size the update region arrays for the display surface.
+//
+//   pass: int lines                    number of scanlines in the surface
+// return: int                          0 if success, -1 if error
+//==============================================================================
+static int video_dirty_configure (int lines)
 {
- struct _dynamic_array *p;
+ video_span_t *span;
+ SDL_Rect *rects;
 
- if ((p = realloc(ap->p, size * ap->entrysize)) == NULL)
-    return 0;
- ap->p = p;
- ap->size = size;
- return !0;
-}
+ if (lines > video_dirty.size)
+    {
+     span = realloc(video_dirty.span, lines * sizeof(video_span_t));
+     if (span)
+        video_dirty.span = span;
+     rects = realloc(video_dirty.rects, lines * sizeof(SDL_Rect));
+     if (rects)
+        video_dirty.rects = rects;
+     if ((! span) || (! rects))
+        {
+         xprintf("video_dirty_configure: Unable to allocate update regions\n");
+         video_dirty.lines = 0;
+         return -1;
+        }
+     video_dirty.size = lines;
+    }
 
-void video_free_array(struct _dynamic_array *ap)
-{
- if (ap->p != NULL)
-    free(ap->p);
- ap->p = NULL;
- ap->size = 0;
- ap->entrysize = 0;
- ap->numentries = 0;
+ memset(video_dirty.span, 0, lines * sizeof(video_span_t));
+ video_dirty.lines = lines;
+ video_dirty.gen = 1;
+ video_dirty.miny = lines;
+ video_dirty.maxy = 0;
+ video_dirty.nrects = 0;
+
+ return 0;
 }
 
-void video_init_array(struct _dynamic_array *ap, int entrysize)
+//==============================================================================
+// Free the update region arrays.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void video_dirty_free (void)
 {
- ap->p = NULL;
- ap->size = 0;
- ap->entrysize = entrysize;
- ap->numentries = 0;
+ free(video_dirty.span);
+ free(video_dirty.rects);
+ memset(&video_dirty, 0, sizeof(video_dirty));
 }
 
-void video_add_update_region(SDL_Rect r)
+//==============================================================================
+// Start a new frame, all scanlines become clean.
+//
+//   pass: void
+// return: void
+//==============================================================================
+static void video_dirty_reset (void)
 {
- int i;
- SDL_Rect *p = video_update_regions->rects.p;
- 
- for (i = 0; i < video_update_regions->rects.a.numentries; ++i)
-    {
-     if (p[i].w == 0)
-        {
-         p[i] = r;
-         return;
-        }
-    }
- if (i >= video_update_regions->rects.a.size)
+ video_dirty.nrects = 0;
+ video_dirty.miny = video_dirty.lines;
+ video_dirty.maxy = 0;
+ if (++video_dirty.gen == 0)
     {
-     video_resize_array(&video_update_regions->rects.a,
-                        video_update_regions->rects.a.size + 20);
-     p = video_update_regions->rects.p;
+     memset(video_dirty.span, 0, video_dirty.lines * sizeof(video_span_t));
+     video_dirty.gen = 1;
     }
- p[i] = r;
- video_update_regions->rects.a.numentries++;
 }
 
 //==============================================================================
+// Build the list of rectangles to be presented from the scanline spans.
 //
-// Add a rectangular region to the list of rectangular regions to redraw
-//
+//   pass: void
+// return: void
 //==============================================================================
-void video_update_region(SDL_Rect r)
+static void video_dirty_rects (void)
 {
- /* This is a naive implementation which scans through the array of
-  * regions.  O(n^2) */
- int i;
- SDL_Rect *p = video_update_regions->rects.p;
-
- for (i = 0; i < video_update_regions->rects.a.numentries; ++i)
-    {
-     /* Wholly contained within another region? */
-     if (r.x >= p[i].x && r.x + r.w <= p[i].x + p[i].w &&
-         r.y >= p[i].y && r.y + r.h <= p[i].y + p[i].h)
-        return;                 /* this rectangle is already being
-                                 * updated */
-     /* Overlapping on top? */
-     if (r.x == p[i].x && r.w == p[i].w &&
-         r.y < p[i].y && r.y + r.h >= p[i].y)
+ int y;
+ video_span_t *sp;
+ SDL_Rect *rp = NULL;
+
+ video_dirty.nrects = 0;
+
+ for (y = video_dirty.miny; y < video_dirty.maxy; y++)
+    {
+     sp = &video_dirty.span[y];
+     if (sp->gen != video_dirty.gen)
         {
-         r.h = p[i].y + p[i].h - r.y;
-         p[i].w = p[i].h = 0;   /* mark slot free */
-         video_update_region(r); /* coalesce the new region with
-                                  * others, if possible */
-         return;
+         rp = NULL;
+         continue;
         }
-     /* Overlapping on the bottom? */
-     if (r.x == p[i].x && r.w == p[i].w &&
-         r.y >= p[i].y && r.y <= p[i].y + p[i].h)
+     if (rp && (rp->x == sp->x1) && (rp->w == sp->x2 - sp->x1))
         {
-         r.h = r.y + r.h - p[i].y;
-         r.y = p[i].y;
-         p[i].w = p[i].h = 0;
-         video_update_region(r);
-         return;
+         rp->h++;
+         continue;
         }
-     /* Overlapping on the left? */
-     if (r.y == p[i].y && r.h == p[i].h &&
-         r.x < p[i].x && r.x + r.w >= p[i].x)
+     rp = &video_dirty.rects[video_dirty.nrects++];
+     rp->x = sp->x1;
+     rp->y = y;
+     rp->w = sp->x2 - sp->x1;
+     rp->h = 1;
+    }
+}
+
+//==============================================================================
+// Add a rectangular region to be updated when the display is presented.
+//
+//   pass: SDL_Rect r                   region of the display surface
+// return: void
+//==============================================================================
+void video_update_region (SDL_Rect r)
+{
+ int x1 = r.x;
+ int x2 = r.x + r.w;
+ int y1 = r.y;
+ int y2 = r.y + r.h;
+ int y;
+ video_span_t *sp;
+
+ if (y1 < 0)
+    y1 = 0;
+ if (y2 > video_dirty.lines)
+    y2 = video_dirty.lines;
+ if ((x1 >= x2) || (y1 >= y2))
+    return;
+
+ for (y = y1, sp = &video_dirty.span[y1]; y < y2; y++, sp++)
+    {
+     if (sp->gen != video_dirty.gen)
         {
-         r.w = p[i].x + p[i].w - r.x;
-         p[i].w = p[i].h = 0;
-         video_update_region(r);
-         return;
+         sp->gen = video_dirty.gen;
+         sp->x1 = x1;
+         sp->x2 = x2;
         }
-     /* Overlapping on the right? */
-     if (r.y == p[i].y && r.h == p[i].h &&
-         r.x >= p[i].x && r.x <= p[i].x + p[i].w)
+     else
         {
-         r.w = r.x + r.w - p[i].x;
-         r.x = p[i].x;
-         p[i].w = p[i].h = 0;
-         video_update_region(r);
-         return;
+         if (x1 < sp->x1)
+            sp->x1 = x1;
+         if (x2 > sp->x2)
+            sp->x2 = x2;
         }
     }
- /* The region couldn't be coalesced, so add it in the first free slot */
- video_add_update_region(r);
+
+ if (y1 < video_dirty.miny)
+    video_dirty.miny = y1;
+ if (y2 > video_dirty.maxy)
+    video_dirty.maxy = y2;
 }
 
-void video_free_update_regions()
+//==============================================================================
+// Set the palette of an 8 bit display surface, and the window surface it's
+// scaled to if the software scaler is used.
+//
+//   pass: SDL_Color *colours           palette colours
+//         int n                        number of colours
+// return: void
+//==============================================================================
+static void video_palette (SDL_Color *colours, int n)
 {
- video_free_array(&video_update_regions->rects.a);
- video_free_array(&video_update_regions->free_rects.a);
+ SDL_SetPalette(screen, SDL_LOGPAL | SDL_PHYSPAL, colours, 0, n);
+ if (scale_screen)
+    SDL_SetPalette(scale_screen, SDL_LOGPAL | SDL_PHYSPAL, colours, 0, n);
 }
 
-void video_init_update_regions()
+//==============================================================================
+// Set the palette of an 8 bit indexed display surface.  The pixels are left
+// alone, the whole display is presented again with the new colours.
+//
+//   pass: SDL_Color *colours           palette colours
+//         int n                        number of colours
+// return: void
+//==============================================================================
+void video_set_palette (SDL_Color *colours, int n)
 {
- // calloc enough space for the update_regions struct
- video_update_regions = calloc(1, sizeof(*video_update_regions));
- video_init_array(&video_update_regions->rects.a,
-                  sizeof(*video_update_regions->rects.p));
- video_init_array(&video_update_regions->free_rects.a,
-                  sizeof(*video_update_regions->free_rects.p));
+ SDL_Rect r;
+
+ if ((! video.indexed) || (! screen))
+    return;
+
+ video_thread_sync();
+ video_palette(colours, n);
+
+ r.x = 0;
+ r.y = 0;
+ r.w = screen->w;
+ r.h = screen->h;
+ video_update_region(r);
+ crtc.update = 1;
 }
 
 
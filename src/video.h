@@ -25,6 +25,7 @@
 #define VIDEO_8GS 1
 #define VIDEO_16 2
 #define VIDEO_32 3
+#define VIDEO_8I 4
 
 #ifdef USE_OPENGL
 // OpenGL video filter values
@@ -63,6 +64,10 @@ void video_convert_crtc_to_mouse_xy (int crtc_x, int crtc_y, int *x, int *y);
 int video_create_window (int crt_w, int crt_h);
 int video_create_surface (int crt_w, int crt_h);
 void video_render (void);
+int video_thread_running (void);
+void video_thread_sync (void);
+void video_draw_surface (void);
+void video_active_event (void);
 
 #ifdef USE_OPENGL
 void video_gl_set_size (int p);
@@ -88,9 +93,18 @@ static inline void video_putpixel_fast(int x, int y, int val)
 int video_toggledisplay (void);
 void video_update (void);
 void video_update_region(SDL_Rect r);
+void video_set_palette (SDL_Color *colours, int n);
 void video_command (int cmd, int p);
 
 #ifdef USE_OPENGL
+// display texture upload methods
+#define VIDEO_GL_UPLOAD_DIRECT 0        /* from the display surface */
+#define VIDEO_GL_UPLOAD_ORPHAN 1        /* pixel buffer orphaned each frame */
+#define VIDEO_GL_UPLOAD_PERSIST 2       /* persistently mapped pixel buffer */
+
+// clean scanlines allowed inside a band of dirty scanlines
+#define VIDEO_GL_BAND_GAP 8
+
 typedef struct video_gl_t
    {
     int ntextures;
@@ -110,9 +124,51 @@ typedef struct video_gl_t
     GLint filter;
     int bpp;
     Uint32 Rmask, Gmask, Bmask, Amask;
+
+    int upload;                 /* texture upload method */
+    GLuint pbo[2];              /* pixel buffers, used on alternate frames */
+    void *pbo_map[2];           /* persistent mappings */
+    void *pbo_fence[2];         /* uploads from each buffer are complete */
+    int pbo_next;
+    int pbo_size;
+
+    uint64_t upload_bytes;      /* upload statistics */
+    int upload_frames;
+    int upload_max;
    }video_gl_t;
 #endif
 
+typedef struct video_span_t
+   {
+    uint32_t gen;               /* frame generation the span belongs to */
+    int x1;                     /* first dirty pixel */
+    int x2;                     /* last dirty pixel + 1 */
+   }video_span_t;
+
+typedef struct video_dirty_t
+   {
+    video_span_t *span;         /* dirty span for each scanline */
+    SDL_Rect *rects;            /* rectangles to be presented */
+    int nrects;
+    int lines;                  /* scanlines in the display surface */
+    int size;                   /* scanlines allocated for */
+    int miny;                   /* first dirty scanline */
+    int maxy;                   /* last dirty scanline + 1 */
+    uint32_t gen;               /* current frame generation */
+   }video_dirty_t;
+
+typedef struct video_thread_t
+   {
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    SDL_cond *work;             /* signalled when a frame is published */
+    SDL_cond *idle;             /* signalled when a frame has been drawn */
+    int pending;                /* a published frame is waiting to be drawn */
+    int busy;                   /* the render thread is drawing a frame */
+    int drawn;                  /* the render thread has drawn something */
+    int terminate;              /* set if the render thread is to terminate */
+   }video_thread_t;
+
 typedef struct video_t
    {
     int desktop_w;
@@ -130,6 +186,13 @@ typedef struct video_t
 
     int flags;
     int bpp;
+    int indexed;                /* pixels are colour table indexes */
+
+    int thread;                 /* render on a separate thread */
+    int diff;                   /* find changed VDU RAM once per frame */
+    int scale;                  /* software scale factor */
+    int scanlines;              /* darken the last row of each scaled row */
+    int hidden;                 /* window is iconified, nothing is drawn */
 
 #ifdef USE_OPENGL
     int gl_window_w;
@@ -154,6 +217,7 @@ typedef struct video_t
 
     int max;
     int vsync;
+    int gl_text;                /* draw the text display with a shader */
 
     int initial_x_pixels;
     int initial_x_percent;
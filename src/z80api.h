@@ -45,6 +45,7 @@ int z80api_reset (void);
 int z80api_getpc (void);
 void z80api_set_poll_tstates_def (int tstates);
 void z80api_set_poll_tstates (int tstates, int repeats);
+void z80api_poll_now (void);
 void z80api_execute (int tstates);
 void z80api_execute_complete (void);
 void z80api_set_pc (int addr);
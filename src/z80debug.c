@@ -32,6 +32,13 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Added z80debug_dump_screen() function for --db-screen option.
+// - The stopped state in z80debug_before() now blocks in input_idle() until
+//   an event arrives instead of waking every 1mS.
+// - z80debug_fill_bank(), z80debug_load_bank() and z80debug_set_bank()
+//   rebuild the VDU PCG glyph index after changing memory.
+//
 // v6.0.0 - 1 January 2017, K Duckmanton
 // - Microbee memory is now an array of uint8_t rather than char.
 //
@@ -195,6 +202,7 @@
 #include "vdu.h"
 #include "console.h"
 #include "gui.h"
+#include "input.h"
 
 #include "macros.h"
 
@@ -897,7 +905,7 @@ int z80debug_before (void)
      if (emu.quit || emu.reset)
         emu.z80_blocks = 0;     // kill the current block loop
      else
-        time_delay_ms(1);  // prevent excessive host CPU time whilst
+        input_idle();      // prevent excessive host CPU time whilst
                            // in step mode
      return -1;
     }
@@ -1950,6 +1958,8 @@ int z80debug_fill_bank (char *p)
  else
     memset(b.ptr, value, b.size);
 
+ vdu_pcg_index_rebuild();  // screen or attribute RAM may have changed
+
  return 0;
 }
 
@@ -2549,6 +2559,8 @@ int z80debug_load_bank (char *p)
     if (fread(b.ptr, b.size, 1, fp) != 1)
        ; // no error
  fclose(fp);
+ vdu_pcg_index_rebuild();  // screen or attribute RAM may have changed
+
  return 0;
 }
 
@@ -2730,6 +2742,8 @@ int z80debug_set_bank (char *p)
         }
     }
 
+ vdu_pcg_index_rebuild();  // screen or attribute RAM may have changed
+
  return 0;
 }
 
@@ -3319,6 +3333,30 @@ void z80debug_dump_registers (void)
  show_registers(&z80x, Z80DEBUG_ALL & ~Z80DEBUG_TSTATE, 5);
 }
 
+//==============================================================================
+// process --db-screen option.
+//
+// Show the visible text screen, see crtc_screen_text().
+//
+//   pass: void
+// return: void
+//==============================================================================
+void z80debug_dump_screen (void)
+{
+ char *s;
+ char *p;
+ char *e;
+
+ if (! (s = malloc(CRTC_TEXT_SIZE)))
+    return;
+
+ if (crtc_screen_text(s, CRTC_TEXT_SIZE) != -1)
+    for (p = s; (e = strchr(p, '\n')); p = e + 1)
+       xprintf("%.*s\n", (int)(e - p), p);
+
+ free(s);
+}
+
 //==============================================================================
 // Process --debug option.
 //
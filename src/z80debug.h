@@ -60,6 +60,7 @@ int z80debug_dump_memory (char *p, int style);
 int z80debug_dump_bank (char *p, int style);
 int z80debug_dump_port (char *p);
 void z80debug_dump_registers (void);
+void z80debug_dump_screen (void);
 int z80debug_fill_bank (char *p);
 int z80debug_fill_memory (char *p);
 int z80debug_find_bank (char *p);
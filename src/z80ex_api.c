@@ -31,6 +31,10 @@
 //==============================================================================
 // ChangeLog (most recent entries are at top)
 //==============================================================================
+// v6.1.0 - 18 October 2026, uBee
+// - Added z80api_poll_now() to request a PIO poll after the current
+//   instruction without changing the polling rate or repeat count.
+//
 // v5.7.0 - 21 July 2015, uBee
 // - Changes to read_mem_cb(), read_mem_debug_cb(), write_mem_cb() and
 //   write_mem_debug_cb() to use new define values of MEMMAP_MASK and
@@ -269,6 +273,19 @@ void z80api_set_poll_tstates (int tstates, int repeats)
  poll_repeats = repeats;
 }
 
+//==============================================================================
+// Request a PIO poll after the current instruction.
+//
+// The polling rate and repeat counter are not changed.
+//
+//   pass: void
+// return: void
+//==============================================================================
+void z80api_poll_now (void)
+{
+ poll_wait_tstates = 0;
+}
+
 //==============================================================================
 // Register an action to occur on a Z80 state change.
 //